@@ -39,6 +39,31 @@ static void print_citation()
 	printf("- Daszykowski et al., J. Chem. Inf. Comput. Sci. 42:500-507, 2002.\n\n");
 }
 
+/*____________________________________________________________________________*/
+/** parse comma-separated list of minPts values */
+static int parse_minpts(char *list, Arg *arg)
+{
+	char *p = list;
+	char *end = 0;
+
+	for (arg->nMinPts = 0; arg->nMinPts < MAXMINPTS; ) {
+		arg->minPtsList[arg->nMinPts ++] = (int)strtol(p, &end, 10);
+		if (end == p)
+			return 1;
+		if (*end == '\0')
+			break;
+		if (*end != ',')
+			return 1;
+		p = end + 1;
+	}
+	if (*end != '\0')
+		return 1;
+
+	arg->minPts = arg->minPtsList[0];
+
+	return 0;
+}
+
 /*____________________________________________________________________________*/
 /** set defaults */
 static void set_defaults(Arg *arg)
@@ -50,7 +75,23 @@ static void set_defaults(Arg *arg)
     arg->uniqueOutFileName = "unique.dat";
     arg->eps = FLT_MAX;
     arg->minPts = 1;
+    arg->minPtsList[0] = 1;
+    arg->nMinPts = 1;
     arg->w = 1;
+    arg->nbIndex = INDEX_BRUTE;
+    arg->nPivot = 16;
+    arg->order = ORDER_LOCAL;
+    arg->coreDist = COREDIST_UNPROCESSED;
+    arg->cdFileName = 0;
+    arg->extract = EXTRACT_SORT;
+    arg->xi = 0.05;
+    arg->nThread = 0;
+    arg->prefetch = 0;
+    arg->stateFileName = 0;
+    arg->resumeFileName = 0;
+    arg->removedFileName = 0;
+    arg->window = 0;
+    arg->stride = 0;
     arg->outPathName = ".";
 }
 
@@ -70,7 +111,22 @@ int parse_args(int argc, char **argv, Arg *arg)
       --uniquefile <filename>              (mode: optional,  type: char,  default: unique.dat)\n\
       --eps <epsilon cutoff>               (mode: optional,  type: float, default: FLT_MAX)\n\
       --minpts <min number of neighbours>  (mode: optional,  type: int,   default: 1)\n\
+               (comma-separated list: one ordering and output file set per value)\n\
       --w <window size for string version> (mode: optional,  type: int,   default: 1)\n\
+      --index <search engine>              (mode: optional,  type: char,  default: brute)\n\
+      --pivots <number of pivots>          (mode: optional,  type: int,   default: 16)\n\
+      --order <local|global|mst>           (mode: optional,  type: char,  default: local)\n\
+      --coredist <unprocessed|all>         (mode: optional,  type: char,  default: unprocessed)\n\
+      --cdfile <filename>                  (mode: optional,  type: char,  default: none)\n\
+      --extract <sort|rmq|xi>              (mode: optional,  type: char,  default: sort)\n\
+      --xi <steepness>                     (mode: optional,  type: float, default: 0.05)\n\
+      --threads <number of threads>        (mode: optional,  type: int,   default: all cores)\n\
+      --prefetch <number of points>        (mode: optional,  type: int,   default: 0 (off))\n\
+      --statefile <filename>               (mode: optional,  type: char,  default: none)\n\
+      --resume <state file>                (mode: optional,  type: char,  default: none)\n\
+      --removed <filename>                 (mode: optional,  type: char,  default: none)\n\
+      --window <number of points>          (mode: optional,  type: int,   default: 0 (off))\n\
+      --stride <number of points>          (mode: optional,  type: int,   default: window)\n\
       --silent                             (mode: optional,  no argument, default: off)\n\
       --cite                               (mode: optional , type: no_arg, default: off)\n\
       --version                            (mode: optional , type: no_arg, default: off)\n\
@@ -79,6 +135,7 @@ int parse_args(int argc, char **argv, Arg *arg)
     optics_str : input data in string format\n\
     optics_vec : input data in vector (of arbitrary length) coordinates\n\
     optics_xyz : input data in Euclidean xyz coordinates\n\n\
+    search engines: brute, kdtree, grid, vptree, mih, pivot\n\n\
     Use the configure options described in 'README' to compile a specific verion.\n";
 
     set_defaults(arg);
@@ -103,6 +160,20 @@ int parse_args(int argc, char **argv, Arg *arg)
         {"minpts", required_argument, 0, 7},
         {"w", required_argument, 0, 8},
         {"silent", no_argument, 0, 9},
+        {"index", required_argument, 0, 11},
+        {"pivots", required_argument, 0, 12},
+        {"order", required_argument, 0, 13},
+        {"statefile", required_argument, 0, 14},
+        {"resume", required_argument, 0, 15},
+        {"removed", required_argument, 0, 16},
+        {"window", required_argument, 0, 17},
+        {"stride", required_argument, 0, 18},
+        {"extract", required_argument, 0, 19},
+        {"xi", required_argument, 0, 20},
+        {"threads", required_argument, 0, 21},
+        {"prefetch", required_argument, 0, 27},
+        {"coredist", required_argument, 0, 25},
+        {"cdfile", required_argument, 0, 26},
         {"cite", no_argument, 0, 22},
         {"version", no_argument, 0, 23},
         {"help", no_argument, 0, 24},
@@ -110,7 +181,7 @@ int parse_args(int argc, char **argv, Arg *arg)
     };
 
     /** assign parameters to long options */
-    while ((c = getopt_long(argc, argv, "1:2:3:4:5:6:7:8:9 10: 22 23 24", long_options, NULL)) != -1)
+    while ((c = getopt_long(argc, argv, "1:2:3:4:5:6:7:8:9 10: 11: 12: 13: 14: 15: 16: 17: 18: 19: 20: 21: 22 23 24 25: 26: 27:", long_options, NULL)) != -1)
     {
         switch(c)
         {
@@ -133,7 +204,11 @@ int parse_args(int argc, char **argv, Arg *arg)
                 arg->eps = atof(optarg);
                 break;
             case 7:
-                arg->minPts = atoi(optarg);
+                if (parse_minpts(optarg, arg) != 0) {
+                    fprintf(stderr, "Invalid minpts '%s': expected up to %d comma-separated integers\n",
+                        optarg, MAXMINPTS);
+                    exit(1);
+                }
                 break;
             case 8:
                 arg->w = atoi(optarg);
@@ -144,6 +219,100 @@ int parse_args(int argc, char **argv, Arg *arg)
             case 10:
                 arg->outPathName = optarg;
                 break;
+            case 11:
+                if (strcmp(optarg, "brute") == 0)
+                    arg->nbIndex = INDEX_BRUTE;
+                else if (strcmp(optarg, "kdtree") == 0)
+                    arg->nbIndex = INDEX_KDTREE;
+                else if (strcmp(optarg, "grid") == 0)
+                    arg->nbIndex = INDEX_GRID;
+                else if (strcmp(optarg, "vptree") == 0)
+                    arg->nbIndex = INDEX_VPTREE;
+                else if (strcmp(optarg, "mih") == 0)
+                    arg->nbIndex = INDEX_MIH;
+                else if (strcmp(optarg, "pivot") == 0)
+                    arg->nbIndex = INDEX_PIVOT;
+                else {
+                    fprintf(stderr, "Unknown neighbour search index '%s'\n", optarg);
+                    fprintf(stderr, "%s", usage);
+                    exit(1);
+                }
+                break;
+            case 12:
+                arg->nPivot = atoi(optarg);
+                if (arg->nPivot < 1) {
+                    fprintf(stderr, "Number of pivots must be positive\n");
+                    exit(1);
+                }
+                break;
+            case 13:
+                if (strcmp(optarg, "local") == 0)
+                    arg->order = ORDER_LOCAL;
+                else if (strcmp(optarg, "global") == 0)
+                    arg->order = ORDER_GLOBAL;
+                else if (strcmp(optarg, "mst") == 0)
+                    arg->order = ORDER_MST;
+                else {
+                    fprintf(stderr, "Unknown ordering '%s'\n", optarg);
+                    fprintf(stderr, "%s", usage);
+                    exit(1);
+                }
+                break;
+            case 14:
+                arg->stateFileName = optarg;
+                break;
+            case 15:
+                arg->resumeFileName = optarg;
+                break;
+            case 16:
+                arg->removedFileName = optarg;
+                break;
+            case 17:
+#ifdef DATAXYZ
+                arg->window = atoi(optarg);
+                if (arg->window < 2) {
+                    fprintf(stderr, "Window size must be at least 2\n");
+                    exit(1);
+                }
+#else
+                fprintf(stderr, "Streaming requires xyz coordinates (optics_xyz)\n");
+                exit(1);
+#endif
+                break;
+            case 18:
+                arg->stride = atoi(optarg);
+                if (arg->stride < 1) {
+                    fprintf(stderr, "Stride must be positive\n");
+                    exit(1);
+                }
+                break;
+            case 19:
+                if (strcmp(optarg, "sort") == 0)
+                    arg->extract = EXTRACT_SORT;
+                else if (strcmp(optarg, "rmq") == 0)
+                    arg->extract = EXTRACT_RMQ;
+                else if (strcmp(optarg, "xi") == 0)
+                    arg->extract = EXTRACT_XI;
+                else {
+                    fprintf(stderr, "Unknown cluster extraction '%s'\n", optarg);
+                    fprintf(stderr, "%s", usage);
+                    exit(1);
+                }
+                break;
+            case 20:
+                arg->xi = atof(optarg);
+                if ((arg->xi <= 0.) || (arg->xi >= 1.)) {
+                    fprintf(stderr, "Steepness xi must be between 0 and 1\n");
+                    exit(1);
+                }
+                break;
+            case 21:
+                arg->nThread = atoi(optarg);
+                if (arg->nThread < 1) {
+                    fprintf(stderr, "Number of threads must be positive\n");
+                    exit(1);
+                }
+                break;
             case 22:
                 print_citation();
                 exit(0);
@@ -155,6 +324,27 @@ int parse_args(int argc, char **argv, Arg *arg)
                 fprintf(stderr, "%s", usage);
 				print_license();
                 exit(0);
+            case 25:
+                if (strcmp(optarg, "unprocessed") == 0)
+                    arg->coreDist = COREDIST_UNPROCESSED;
+                else if (strcmp(optarg, "all") == 0)
+                    arg->coreDist = COREDIST_ALL;
+                else {
+                    fprintf(stderr, "Unknown core distance '%s'\n", optarg);
+                    fprintf(stderr, "%s", usage);
+                    exit(1);
+                }
+                break;
+            case 26:
+                arg->cdFileName = optarg;
+                break;
+            case 27:
+                arg->prefetch = atoi(optarg);
+                if (arg->prefetch < 0) {
+                    fprintf(stderr, "Number of prefetched points must not be negative\n");
+                    exit(1);
+                }
+                break;
             default:
                 fprintf(stderr, "%s", usage);
 				print_license();
@@ -162,6 +352,44 @@ int parse_args(int argc, char **argv, Arg *arg)
         }
     }
 
+    /* the spanning tree ordering is not built step by step */
+    if ((arg->order == ORDER_MST) &&
+        (arg->stateFileName || arg->resumeFileName || arg->removedFileName)) {
+        fprintf(stderr, "Incremental updates require the local or global ordering\n");
+        exit(1);
+    }
+
+    /* core distances over all points change with every added point */
+    if ((arg->coreDist == COREDIST_ALL) &&
+        (arg->stateFileName || arg->resumeFileName || arg->removedFileName)) {
+        fprintf(stderr, "Incremental updates require core distances over unprocessed points\n");
+        exit(1);
+    }
+
+    /* a new window is ordered after 'stride' points, by default the window size */
+    if (arg->stride == 0)
+        arg->stride = arg->window;
+    if ((arg->window > 0) && (arg->resumeFileName || arg->removedFileName)) {
+        fprintf(stderr, "Streaming cannot be combined with '--resume' or '--removed'\n");
+        exit(1);
+    }
+
+#if defined MPI && defined DATAXYZ
+    /* distributed data are searched by the local and global orderings only;
+        the search index of each rank is used up by one ordering */
+    if ((arg->order == ORDER_MST) || (arg->coreDist == COREDIST_ALL) || (arg->nMinPts > 1) ||
+        (arg->window > 0) || arg->resumeFileName || arg->removedFileName) {
+        fprintf(stderr, "optics_xyz_mpi requires the local or global ordering with a single minpts value\n");
+        fprintf(stderr, "and cannot be combined with '--coredist all', '--window', '--resume' or '--removed'\n");
+        exit(1);
+    }
+#endif
+
+    if ((arg->nMinPts > 1) && arg->resumeFileName) {
+        fprintf(stderr, "Resuming an ordering requires a single minpts value\n");
+        exit(1);
+    }
+
     if (! silent) {
 		print_header();
 		fflush(stdout);
@@ -11,6 +11,39 @@ Read the COPYING file for license information.
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/*____________________________________________________________________________*/
+/* neighbour search engines */
+#define INDEX_BRUTE 0 /* scan over all points */
+#define INDEX_KDTREE 1 /* k-d tree range search (xyz, ang) */
+#define INDEX_GRID 2 /* uniform grid with cell edge epsilon (xyz, ang) */
+#define INDEX_VPTREE 3 /* vantage-point tree for metric distances */
+#define INDEX_MIH 4 /* multi-index hashing of string segments (str) */
+#define INDEX_PIVOT 5 /* pivot table (LAESA) for metric distances */
+#define INDEX_CACHE 6 /* precomputed epsilon neighbourhoods (several minPts) */
+#define INDEX_SLICE 7 /* range queries answered by all MPI ranks (optics_xyz_mpi) */
+
+/*____________________________________________________________________________*/
+/* orderings */
+#define ORDER_LOCAL 0 /* closest neighbour of the current point */
+#define ORDER_GLOBAL 1 /* lowest RD of all reached points (seed list) */
+#define ORDER_MST 2 /* minimum spanning tree over mutual reachability */
+
+/*____________________________________________________________________________*/
+/* core distances of the local and global orderings */
+#define COREDIST_UNPROCESSED 0 /* over the unprocessed points (Pandini et al.) */
+#define COREDIST_ALL 1 /* over all points, computed before the ordering */
+
+/*____________________________________________________________________________*/
+/* cluster extraction */
+#define EXTRACT_SORT 0 /* sort each cluster by RD (Pandini et al.) */
+#define EXTRACT_RMQ 1 /* same clusters from range queries on the ordering */
+#define EXTRACT_XI 2 /* steep areas of the RD plot (Ankerst et al.) */
+
+/*____________________________________________________________________________*/
+/* maximal number of values of '--minpts' */
+#define MAXMINPTS 64
 
 /*____________________________________________________________________________*/
 /* structures */
@@ -30,7 +63,23 @@ typedef struct
     char *uniqueOutFileName;
     float eps;
     int minPts;
+    int minPtsList[MAXMINPTS];
+    int nMinPts;
     int w;
+    int nbIndex;
+    int nPivot;
+    int order;
+    int coreDist;
+    char *cdFileName;
+    int extract;
+    float xi;
+    int nThread;
+    int prefetch;
+    char *stateFileName;
+    char *resumeFileName;
+    char *removedFileName;
+    int window;
+    int stride;
 	char *outPathName;
 } Arg;
 
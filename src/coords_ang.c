@@ -15,12 +15,23 @@ void print_header_object(FILE *outfile){
 }
 
 /*____________________________________________________________________________*/
-/* print data point */
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
-    fprintf(outfile, "%10d %10d %10d %8.3f %8.3f %8.3f %8.3f %8.3f\n", 
-            index, order, cluster_id,
-            coreDist, reachDist, 
-            dat->data[index].phi1, dat->data[index].phi2, dat->data[index].theta);  
+/* format data point */
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
+    s = format_int(s, index, 10, ' ');
+    s = format_int(s, order, 10, ' ');
+    s = format_int(s, cluster_id, 10, ' ');
+    s = format_float(s, coreDist, 8, ' ');
+    s = format_float(s, reachDist, 8, ' ');
+    s = format_float(s, dat->data[index].phi1, 8, ' ');
+    s = format_float(s, dat->data[index].phi2, 8, ' ');
+    s = format_float(s, dat->data[index].theta, 8, '\n');
+    return s;
+}
+
+/*____________________________________________________________________________*/
+/* maximal length of a formatted data point */
+int format_object_length(Dat *dat){
+    return 3 * (FORMAT_INT + 1) + 5 * (FORMAT_FLOAT + 1);
 }
 
 /*____________________________________________________________________________*/
@@ -42,6 +53,12 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg){
     return dist;
 }
 
+/*____________________________________________________________________________*/
+/* distance is not guaranteed to be a metric: theta differences are truncated */
+int metric_dist(void){
+    return 0;
+}
+
 /*____________________________________________________________________________*/
 /* read data points */
 /* Data points are expected to be an array of angles in 3D with
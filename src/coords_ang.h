@@ -13,6 +13,7 @@ Read the COPYING file for license information.
 
 #include "arg.h"
 #include "config.h"
+#include "format.h"
 #include "safe.h"
 
 /* input data */
@@ -31,7 +32,9 @@ typedef struct {
 /* prototypes */
 int get_data(char *inFileName, Dat *dat);
 float calc_dist(Dat *dat, int i, int j, Arg *arg);
+int metric_dist(void);
 void print_header_object(FILE *outfile);
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+int format_object_length(Dat *dat);
 
 #endif
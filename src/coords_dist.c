@@ -13,11 +13,20 @@ void print_header_object(FILE *outfile){
 }
 
 /*____________________________________________________________________________*/
-/* print data point */
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
-    fprintf(outfile, "%10d %10d %10d %8.3f %8.3f\n", 
-            index, order, cluster_id,
-            coreDist, reachDist); 
+/* format data point */
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
+    s = format_int(s, index, 10, ' ');
+    s = format_int(s, order, 10, ' ');
+    s = format_int(s, cluster_id, 10, ' ');
+    s = format_float(s, coreDist, 8, ' ');
+    s = format_float(s, reachDist, 8, '\n');
+    return s;
+}
+
+/*____________________________________________________________________________*/
+/* maximal length of a formatted data point */
+int format_object_length(Dat *dat){
+    return 3 * (FORMAT_INT + 1) + 2 * (FORMAT_FLOAT + 1);
 }
 
 /*____________________________________________________________________________*/
@@ -26,28 +35,82 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg){
     return dat->dist[i][j];
 }
 
+/*____________________________________________________________________________*/
+/* distance is not guaranteed to be a metric: arbitrary input matrix */
+int metric_dist(void){
+    return 0;
+}
+
+/*____________________________________________________________________________*/
+/* number of distances in a line */
+static int count_dist(char *begin, char *end)
+{
+	char *pos = begin;
+	char token[2];
+	int n = 0;
+
+	while (load_token(&pos, end, token, sizeof(token)) != 0)
+		++ n;
+
+	return n;
+}
+
+/*____________________________________________________________________________*/
+/* parse the distances of a line, the first being distance 'item'
+	of the triangular matrix (row by row, without the diagonal) */
+static int parse_dist(char *begin, char *end, int item, void *data)
+{
+	Dat *dat = (Dat *)data;
+	unsigned int dim = dat->nData; /* dimension of input matrix */
+	unsigned int i = 0;
+	unsigned int j;
+	float dist = 0.; /* point distance */
+	char *pos = begin;
+	int n;
+
+	/* row and column of the first distance */
+	while (item >= (dim - 1 - i)) {
+		item -= dim - 1 - i;
+		++ i;
+	}
+	j = i + 1 + item;
+
+	for (n = count_dist(begin, end); n > 0; -- n) {
+		/* scan distance data */
+		if (! load_float(&pos, end, &dist))
+			return 0;
+		/* assign distance values to symmetric matrix */
+		dat->dist[i][j] = dist;
+		dat->dist[j][i] = dist;
+		/* advance row and reset column for new row */
+		if (++ j == dim) {
+			++ i;
+			j = i + 1;
+		}
+	}
+
+	return 1;
+}
+
 /*____________________________________________________________________________*/
 /* read distances */
-/* distances are expected to be in the form of a triangular matrix of floats */
+/* distances are expected to be in the form of a triangular matrix of floats;
+	the file is parsed in chunks on several threads (load.c) */
 int get_data(char *inFileName, Dat *dat)
 {
-	FILE *inFile = 0;
+	Load load;
 	unsigned int nd = 0; /* number of data points */
 	unsigned int ndsym = 0;
-	float dummy = 0.;
-	float dist = 0.; /* point distance */
 	unsigned int dim; /* dimension of input matrix */
+#ifdef DEBUG
 	unsigned int i = 0;
 	unsigned int j = 0;
+#endif
 
-	inFile = safe_open(inFileName, "r");
+	load_open(&load, inFileName);
 
 	/* count number of data points  */
-	while(! feof(inFile)) {
-		if (fscanf(inFile, "%f", &dummy) == 1) {
-			++ nd;
-		}
-	}
+	nd = load_count(&load, count_dist);
 	assert(nd > 1);
 	fprintf(stdout, "%d distances in triangular input matrix\n", nd);
 
@@ -63,25 +126,8 @@ int get_data(char *inFileName, Dat *dat)
 	init_mat2D_float(dat->dist, dim, dim, 0.);
 
 	/* read distances */
-	rewind(inFile);
-
-	while(! feof(inFile)) {
-		/* scan distance data */
-		if (fscanf(inFile, "%f", &dist) == 1) {
-			/* advance column */
-			++ j;
-			/* advance row and reset column for new row */
-			if (j == dim) {
-				++ i;
-				j = i + 1;
-			}
-			/* assign distance values to symmetric matrix */
-			dat->dist[i][j] = dist; 
-			dat->dist[j][i] = dist;
-		}
-	}
-
-	fclose(inFile);
+	load_parse(&load, parse_dist, dat);
+	load_close(&load);
 
 #ifdef DEBUG
 	for (i = 0; i < dim; ++ i) {
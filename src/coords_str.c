@@ -13,12 +13,25 @@ void print_header_object(FILE *outfile){
 }
 
 /*____________________________________________________________________________*/
-/* print data point */
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
-    fprintf(outfile, "%10d %10d %10d %8.3f %8.3f %s\n", 
-            index, order, cluster_id,
-            coreDist, reachDist,
-            dat->data[index].string); 
+/* format data point */
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
+    int length = strlen(dat->data[index].string);
+
+    s = format_int(s, index, 10, ' ');
+    s = format_int(s, order, 10, ' ');
+    s = format_int(s, cluster_id, 10, ' ');
+    s = format_float(s, coreDist, 8, ' ');
+    s = format_float(s, reachDist, 8, ' ');
+    memcpy(s, dat->data[index].string, length);
+    s += length;
+    *(s ++) = '\n';
+    return s;
+}
+
+/*____________________________________________________________________________*/
+/* maximal length of a formatted data point */
+int format_object_length(Dat *dat){
+    return 3 * (FORMAT_INT + 1) + 2 * (FORMAT_FLOAT + 1) + sizeof(dat->data[0].string);
 }
 
 /*____________________________________________________________________________*/
@@ -48,46 +61,47 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg){
 
 }
 
+/*____________________________________________________________________________*/
+/* distance is a metric: Hamming distance over windows */
+int metric_dist(void){
+    return 1;
+}
+
+/*____________________________________________________________________________*/
+/* parse data point 'item' from its line 'label string' */
+static int parse_string(char *begin, char *end, int item, void *data)
+{
+	String *string = &(((String *)data)[item]);
+	char *pos = begin;
+	char rest[2];
+
+	return ((load_token(&pos, end, string->label, sizeof(string->label)) > 0) &&
+			(load_token(&pos, end, string->string, sizeof(string->string)) > 0) &&
+			(load_token(&pos, end, rest, sizeof(rest)) == 0));
+}
+
 /*____________________________________________________________________________*/
 /* read data points */
 /* Data points are expected to be an array of strings in a text file
  *     first column: label
- *     second column: data string. */
+ *     second column: data string.
+ * The file is parsed in chunks on several threads (load.c). */
 int get_data(char *inFileName, Dat *dat)
 {
-	FILE *inFile = 0;
-	unsigned int allocated = 64;
-	unsigned int n = 0;
+	Load load;
 
-	/* read data */
-	inFile = safe_open(inFileName, "r");
+	load_open(&load, inFileName);
 
 	/* allocate memory */
-	dat->data = safe_malloc(allocated * sizeof(String));
-
-	dat->nData = 0;
-	while(! feof(inFile)) {
-		++ n;
-#ifdef DEBUG
-		if (fscanf(inFile, "%s %s\n", dat->data[dat->nData].label, dat->data[dat->nData].string) == 2) {
-			fprintf(stderr, "input data format has to be: [string] [string]\n");
-			fprintf(stderr, "format error in line %d\n", n);
-			exit(1);
-		}
-#else
-        assert(fscanf(inFile, "%s %s\n", dat->data[dat->nData].label, dat->data[dat->nData].string) == 2);
-#endif
-		++ dat->nData;
-
-		if (dat->nData == allocated) {
-			allocated += 64;
-			dat->data = safe_realloc(dat->data, allocated * sizeof(String));
-		}
-	}
+	dat->nData = load_count(&load, load_line_item);
+	dat->data = safe_malloc((dat->nData + 1) * sizeof(String));
+
+	/* read data */
+	load_parse(&load, parse_string, dat->data);
+	load_close(&load);
 
 	assert(dat->nData > 1);
 
-	fclose(inFile);
 	return 0;
 }
 
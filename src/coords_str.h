@@ -11,6 +11,8 @@ Read the COPYING file for license information.
 
 #include "arg.h"
 #include "config.h"
+#include "format.h"
+#include "load.h"
 #include "safe.h"
 
 /* input data */
@@ -28,7 +30,9 @@ typedef struct {
 /* prototypes */
 int get_data(char *inFileName, Dat *dat);
 float calc_dist(Dat *dat, int i, int j, Arg *arg);
+int metric_dist(void);
 void print_header_object(FILE *outfile);
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+int format_object_length(Dat *dat);
 
 #endif
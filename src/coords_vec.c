@@ -9,6 +9,12 @@ Read the COPYING file for license information.
 /* define distance metric: KLD, SKLD, SHD, CTD, MHD */
 #define MHD
 
+/*____________________________________________________________________________*/
+/* vector of data point i */
+__inline__ static float *vec_row(Dat *dat, int i) {
+	return &(dat->data[(size_t)i * dat->stride]);
+}
+
 /*____________________________________________________________________________*/
 /* print header for point */
 void print_header_object(FILE *outfile) {
@@ -17,16 +23,26 @@ void print_header_object(FILE *outfile) {
 }
 
 /*____________________________________________________________________________*/
-/* print data point */
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist) {
+/* format data point */
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist) {
 	unsigned int k;
+	float *v = vec_row(dat, index);
 
-    fprintf(outfile, "%10d %10d %10d %8.3f %8.3f ", 
-            index, order, cluster_id,
-            coreDist, reachDist);
+    s = format_int(s, index, 10, ' ');
+    s = format_int(s, order, 10, ' ');
+    s = format_int(s, cluster_id, 10, ' ');
+    s = format_float(s, coreDist, 8, ' ');
+    s = format_float(s, reachDist, 8, ' ');
 	for (k = 0; k < dat->lData; ++ k)
-		fprintf(outfile, "%8.3f ", dat->data[index][k]); 
-    fprintf(outfile, "\n"); 
+		s = format_float(s, v[k], 8, ' ');
+    *(s ++) = '\n';
+    return s;
+}
+
+/*____________________________________________________________________________*/
+/* maximal length of a formatted data point */
+int format_object_length(Dat *dat) {
+    return 3 * (FORMAT_INT + 1) + (2 + dat->lData) * (FORMAT_FLOAT + 1) + 1;
 }
 
 /*____________________________________________________________________________*/
@@ -34,11 +50,13 @@ void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id,
 #ifdef KLD
 float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 	unsigned int k;
+	float *x = vec_row(dat, i);
+	float *y = vec_row(dat, j);
     float dist = 0.;
 
 	for (k = 0; k < dat->lData; ++ k)
-		if ((dat->data[i][k] > 0.) && (dat->data[j][k] > 0.))
-            dist += dat->data[i][k] * log(dat->data[i][k] / dat->data[j][k]);
+		if ((x[k] > 0.) && (y[k] > 0.))
+            dist += x[k] * log(x[k] / y[k]);
     return dist;
 }
 #endif
@@ -48,12 +66,14 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 #ifdef SKLD
 float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 	unsigned int k;
+	float *x = vec_row(dat, i);
+	float *y = vec_row(dat, j);
     float dist = 0.;
 
 	for (k = 0; k < dat->lData; ++ k)
-		if ((dat->data[i][k] > 0.) && (dat->data[j][k] > 0.))
-            dist += (.5 * dat->data[i][k] * log(dat->data[i][k] / dat->data[j][k])) +\
-					(.5 * dat->data[j][k] * log(dat->data[j][k] / dat->data[i][k]));
+		if ((x[k] > 0.) && (y[k] > 0.))
+            dist += (.5 * x[k] * log(x[k] / y[k])) +\
+					(.5 * y[k] * log(y[k] / x[k]));
     return dist;
 }
 #endif
@@ -63,18 +83,20 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 #ifdef SHD
 float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 	unsigned int k;
+	float *x = vec_row(dat, i);
+	float *y = vec_row(dat, j);
     float dist = 0.;
 	float s_x = 0.;
 	float s_y = 0.;
 	float s_xy = 0.;
 
 	for (k = 0; k < dat->lData; ++ k) {
-		if (dat->data[i][k] > 0)
-			s_x += dat->data[i][k] * log2(dat->data[i][k]);
-		if (dat->data[j][k] > 0)
-			s_y += dat->data[j][k] * log2(dat->data[j][k]);
-		if ((dat->data[i][k] > 0) && (dat->data[j][k] > 0))
-			s_xy += (dat->data[i][k] + dat->data[j][k]) * log2(dat->data[i][k] + dat->data[j][k]);
+		if (x[k] > 0)
+			s_x += x[k] * log2(x[k]);
+		if (y[k] > 0)
+			s_y += y[k] * log2(y[k]);
+		if ((x[k] > 0) && (y[k] > 0))
+			s_xy += (x[k] + y[k]) * log2(x[k] + y[k]);
 	}
 
 	dist = .5 * (s_xy - (s_x + s_y));
@@ -88,11 +110,13 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 #ifdef CTD
 float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 	unsigned int k;
+	float *x = vec_row(dat, i);
+	float *y = vec_row(dat, j);
     float dist = 0.;
 	float squaresum = 0.;
 
 	for (k = 0; k < dat->lData; ++ k)
-		squaresum += pow(dat->data[i][k] - dat->data[j][k], 2);
+		squaresum += pow(x[k] - y[k], 2);
 
 	dist = sqrt(squaresum / dat->lData);
 
@@ -105,85 +129,134 @@ float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 #ifdef MHD
 float calc_dist(Dat *dat, int i, int j, Arg *arg) {
 	unsigned int k;
+	float *x = vec_row(dat, i);
+	float *y = vec_row(dat, j);
     float dist = 0.;
 
 	for (k = 0; k < dat->lData; ++ k)
-		dist += abs(dat->data[i][k] - dat->data[j][k]);
+		dist += fabs(x[k] - y[k]);
 
     return dist;
 }
 #endif
 
+/*____________________________________________________________________________*/
+/* distance is a metric (symmetric, triangle inequality): CTD and MHD */
+int metric_dist(void) {
+#if defined CTD || defined MHD
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /*----------------------------------------------------------------------------*/
 __inline__ int approximately_equal(float a, float b)
 {
 	return (int)(a == b || fabsf(a - b) <= .00001F * fabsf(a) + .00001F);
 }
 
+/*____________________________________________________________________________*/
+/* vectors and their lengths while parsing */
+typedef struct {
+	Dat *dat; /* data points */
+	int *length; /* length of each vector */
+} VecParse;
+
+/*____________________________________________________________________________*/
+/* number of vector elements in the line [begin, end) */
+static int count_vector(char *begin, char *end)
+{
+	char token[128];
+	int k = 0;
+
+	while (load_token(&begin, end, token, sizeof(token)) != 0)
+		++ k;
+
+	return k;
+}
+
+/*____________________________________________________________________________*/
+/* parse data point 'item' from its line of vector elements;
+	elements beyond the vector length only count (see get_data) */
+static int parse_vector(char *begin, char *end, int item, void *data)
+{
+	VecParse *vecParse = (VecParse *)data;
+	float *v = vec_row(vecParse->dat, item);
+	char *pos = begin;
+	char token[128];
+	char *tokenEnd;
+	double value;
+	int k = 0;
+	int n;
+
+	while ((n = load_token(&pos, end, token, sizeof(token))) != 0) {
+		if (n < 0)
+			return 0;
+		value = strtod(token, &tokenEnd);
+		if (*tokenEnd != '\0')
+			return 0;
+		if (k < vecParse->dat->lData)
+			v[k] = value;
+		++ k;
+	}
+	vecParse->length[item] = k;
+
+	/* zero padding */
+	for (k = (k < vecParse->dat->lData) ? k : vecParse->dat->lData; k < vecParse->dat->stride; ++ k)
+		v[k] = 0.;
+
+	return 1;
+}
+
 /*____________________________________________________________________________*/
 /* read data points */
-/* Data points are expected to be an array of vectors of arbitrary length;
-	note that the maximal vector length can be adjusted (see below).
-	The vectors must be of equal length. */
+/* Data points are expected to be an array of vectors of arbitrary length,
+	one per line. The vectors must be of equal length: the length of the
+	first vector sets the row stride of the data array.
+	The file is parsed in chunks on several threads (load.c). */
 int get_data(char *inFileName, Dat *dat)
 {
-	FILE *inFile = 0;
-	unsigned int allocated = 64;
-	char line[512] = "";
-	char cpline[512] = "";
-	char *pch = 0;
-	unsigned int k;
+	Load load;
+	VecParse vecParse;
+	char *begin, *end;
+	char *fileEnd;
+	void *block = 0;
+	size_t size;
+	int i;
+
+	load_open(&load, inFileName);
+
+	/* vector length from the first non-blank line */
+	dat->lData = 0;
+	fileEnd = &(load.text[load.size]);
+	for (begin = load.text; (begin < fileEnd) && (dat->lData == 0); begin = end + 1) {
+		end = memchr(begin, '\n', fileEnd - begin);
+		end = (end != 0) ? end : fileEnd;
+		dat->lData = count_vector(begin, end);
+	}
+	dat->stride = (dat->lData + VEC_BLOCK - 1) / VEC_BLOCK * VEC_BLOCK;
+
 	/* allocate memory */
-	/* The maximal vector length is defined in *data[512] 
-		in the coord_vec.h header. If you modify the 512
-		to a 2048 (for example), then set maxDim also to 2048. */
-	const int maxDim = 512;
-	dat->data = safe_malloc(allocated * sizeof(float [maxDim]));
-	pch = safe_malloc(allocated * sizeof(char));
+	dat->nData = load_count(&load, load_line_item);
+	size = (size_t)(dat->nData + 1) * dat->stride * sizeof(float);
+	if (posix_memalign(&block, VEC_ALIGN, (size > 0) ? size : VEC_ALIGN) != 0) {
+		fprintf(stderr, "Error: Failed allocating %d vectors of length %d\n", dat->nData, dat->lData);
+		exit(1);
+	}
+	dat->data = (float *)block;
+	vecParse.dat = dat;
+	vecParse.length = safe_malloc((dat->nData + 1) * sizeof(int));
 
 	/* read input data */
-	inFile = safe_open(inFileName, "r");
-
-	/* process input data */
-	dat->nData = 0;
-	while(fgets(line, maxDim, inFile) != NULL) {
-		k = 0;
-		/* read line */
-#ifdef DEBUG
-		fprintf(stderr, "%s", line);
-#endif
-		strcpy(&(cpline[0]), &(line[0]));
-		/* split line and assign first vector element */
-		pch = strtok(cpline, " ");
-		dat->data[dat->nData][k ++] = atof(pch);
-		/* assign remaining vector elements */
-		while (pch != NULL) {
-			pch = (strtok(NULL, " "));
-			if (pch != NULL) {
-				dat->data[dat->nData][k ++] = atof(pch); 
-			}
-			/* check for absolute vector length */
-			assert((k < maxDim) && "Increase *data[] array in coord_vec.h!\n");
-        }
-
-		/* check for relative vector length */
-		if (dat->nData == 0) {
-			dat->lData = k;
-		} else {
-			assert((k == dat->lData) && "Input vectors must be of equal length!\n");
-		}
-
-		++ dat->nData;
-
-		/* allocate additional memory */
-		if (dat->nData == allocated) {
-			allocated += 64;
-			dat->data = safe_realloc(dat->data, allocated * sizeof(float [maxDim]));
-		}
+	load_parse(&load, parse_vector, &vecParse);
+	load_close(&load);
+
+	/* check for relative vector length */
+	for (i = 0; i < dat->nData; ++ i) {
+		assert((vecParse.length[i] == dat->lData) && "Input vectors must be of equal length!\n");
 	}
 
-	fclose(inFile);
-	free(pch);
+	free(vecParse.length);
 	return 0;
 }
-
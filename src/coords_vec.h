@@ -14,20 +14,30 @@ Read the COPYING file for license information.
 
 #include "arg.h"
 #include "config.h"
+#include "format.h"
+#include "load.h"
 #include "safe.h"
 
+/* row stride in floats is a multiple of VEC_BLOCK (SIMD width) */
+#define VEC_BLOCK 8
+/* alignment of the data array in bytes */
+#define VEC_ALIGN 64
+
 /* input data */
 typedef struct {
-	float (*data)[512]; /* input data to order */
+	float *data; /* input data to order: row i starts at data[i * stride] */
 	int nData; /* number of data points */
 	int lData; /* length of data vector */
+	int stride; /* row length: lData padded with zeros to VEC_BLOCK */
 } Dat;
 
 /*____________________________________________________________________________*/
 /* prototypes */
 int get_data(char *inFileName, Dat *dat);
 float calc_dist(Dat *dat, int i, int j, Arg *arg);
+int metric_dist(void);
 void print_header_object(FILE *outfile);
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+int format_object_length(Dat *dat);
 
 #endif
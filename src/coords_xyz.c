@@ -6,6 +6,12 @@ Read the COPYING file for license information.
 
 #include "coords_xyz.h"
 
+/* vectorised distance kernel, selected at run time if the CPU has AVX */
+#if defined __GNUC__ && (defined __x86_64__ || defined __i386__)
+#include <immintrin.h>
+#define XYZ_AVX
+#endif
+
 /*____________________________________________________________________________*/
 /* print header for point */
 void print_header_object(FILE *outfile){
@@ -13,65 +19,209 @@ void print_header_object(FILE *outfile){
 }
 
 /*____________________________________________________________________________*/
-/* print data point */
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
-    fprintf(outfile, "%10d %10d %10d %8.3f %8.3f %8.3f %8.3f %8.3f\n", 
-            index, order, cluster_id,
-            coreDist, reachDist,
-            dat->data[index].x, dat->data[index].y, dat->data[index].z); 
+/* format data point */
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist){
+    s = format_int(s, index, 10, ' ');
+    s = format_int(s, order, 10, ' ');
+    s = format_int(s, cluster_id, 10, ' ');
+    s = format_float(s, coreDist, 8, ' ');
+    s = format_float(s, reachDist, 8, ' ');
+    s = format_float(s, dat->x[index], 8, ' ');
+    s = format_float(s, dat->y[index], 8, ' ');
+    s = format_float(s, dat->z[index], 8, '\n');
+    return s;
+}
+
+/*____________________________________________________________________________*/
+/* maximal length of a formatted data point */
+int format_object_length(Dat *dat){
+    return 3 * (FORMAT_INT + 1) + 5 * (FORMAT_FLOAT + 1);
 }
 
 /*____________________________________________________________________________*/
 /* calculate distance */
+/* as v_rmsd(): coordinate differences in float, squares and sum in double */
 float calc_dist(Dat *dat, int i, int j, Arg *arg){
 
     float dist;
 
-    dist = v_rmsd(&(dat->data[i]), &(dat->data[j]));
+    dist = sqrt(pow(dat->x[i] - dat->x[j], 2)
+              + pow(dat->y[i] - dat->y[j], 2)
+              + pow(dat->z[i] - dat->z[j], 2));
 
     return dist;
 }
 
+#ifdef XYZ_AVX
+/*____________________________________________________________________________*/
+/* distances from 8 coordinate differences with AVX: squares, sums and
+	roots of 4 values in double at a time, as in calc_dist() */
+__attribute__((target("avx"), always_inline))
+__inline__ static unsigned int dist_avx(__m256 dx, __m256 dy, __m256 dz, float eps, float *dist)
+{
+	__m256d d[2];
+	__m256d c;
+	__m256 d8;
+	int h;
+
+	for (h = 0; h < 2; ++ h) {
+		c = _mm256_cvtps_pd((h == 0) ? _mm256_castps256_ps128(dx) : _mm256_extractf128_ps(dx, 1));
+		d[h] = _mm256_mul_pd(c, c);
+		c = _mm256_cvtps_pd((h == 0) ? _mm256_castps256_ps128(dy) : _mm256_extractf128_ps(dy, 1));
+		d[h] = _mm256_add_pd(d[h], _mm256_mul_pd(c, c));
+		c = _mm256_cvtps_pd((h == 0) ? _mm256_castps256_ps128(dz) : _mm256_extractf128_ps(dz, 1));
+		d[h] = _mm256_add_pd(d[h], _mm256_mul_pd(c, c));
+		d[h] = _mm256_sqrt_pd(d[h]);
+	}
+
+	d8 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(d[0])), _mm256_cvtpd_ps(d[1]), 1);
+	_mm256_storeu_ps(dist, d8);
+
+	return (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(d8, _mm256_set1_ps(eps), _CMP_LE_OQ));
+}
+
+/*____________________________________________________________________________*/
+/* calc_dist_block() with AVX: coordinate differences in float */
+__attribute__((target("avx")))
+static unsigned int calc_dist_block_avx(Dat *dat, int i, int first, float eps, float *dist)
+{
+	__m256 dx = _mm256_sub_ps(_mm256_set1_ps(dat->x[i]), _mm256_loadu_ps(&(dat->x[first])));
+	__m256 dy = _mm256_sub_ps(_mm256_set1_ps(dat->y[i]), _mm256_loadu_ps(&(dat->y[first])));
+	__m256 dz = _mm256_sub_ps(_mm256_set1_ps(dat->z[i]), _mm256_loadu_ps(&(dat->z[first])));
+
+	return dist_avx(dx, dy, dz, eps, dist);
+}
+
+/*____________________________________________________________________________*/
+/* calc_dist_gather() with AVX: the coordinates of the 8 points are
+	gathered into vectors, then as calc_dist_block_avx() */
+__attribute__((target("avx")))
+static unsigned int calc_dist_gather_avx(Dat *dat, int i, int *index, float eps, float *dist)
+{
+	__m256 dx = _mm256_sub_ps(_mm256_set1_ps(dat->x[i]),
+		_mm256_set_ps(dat->x[index[7]], dat->x[index[6]], dat->x[index[5]], dat->x[index[4]],
+			dat->x[index[3]], dat->x[index[2]], dat->x[index[1]], dat->x[index[0]]));
+	__m256 dy = _mm256_sub_ps(_mm256_set1_ps(dat->y[i]),
+		_mm256_set_ps(dat->y[index[7]], dat->y[index[6]], dat->y[index[5]], dat->y[index[4]],
+			dat->y[index[3]], dat->y[index[2]], dat->y[index[1]], dat->y[index[0]]));
+	__m256 dz = _mm256_sub_ps(_mm256_set1_ps(dat->z[i]),
+		_mm256_set_ps(dat->z[index[7]], dat->z[index[6]], dat->z[index[5]], dat->z[index[4]],
+			dat->z[index[3]], dat->z[index[2]], dat->z[index[1]], dat->z[index[0]]));
+
+	return dist_avx(dx, dy, dz, eps, dist);
+}
+#endif
+
+/*____________________________________________________________________________*/
+/* distances of point i to the XYZ_BLOCK points from 'first' into 'dist';
+	returns the bit mask of the points within 'eps' (bit k: point first + k).
+	The distances equal those of calc_dist(). */
+unsigned int calc_dist_block(Dat *dat, int i, int first, float eps, float *dist)
+{
+	int k;
+	unsigned int mask = 0;
+
+#ifdef XYZ_AVX
+	if (__builtin_cpu_supports("avx"))
+		return calc_dist_block_avx(dat, i, first, eps, dist);
+#endif
+
+	for (k = 0; k < XYZ_BLOCK; ++ k) {
+		dist[k] = calc_dist(dat, i, first + k, 0);
+		if (dist[k] <= eps)
+			mask |= (1u << k);
+	}
+
+	return mask;
+}
+
+/*____________________________________________________________________________*/
+/* as calc_dist_block() for the XYZ_BLOCK points index[0], ... */
+unsigned int calc_dist_gather(Dat *dat, int i, int *index, float eps, float *dist)
+{
+	int k;
+	unsigned int mask = 0;
+
+#ifdef XYZ_AVX
+	if (__builtin_cpu_supports("avx"))
+		return calc_dist_gather_avx(dat, i, index, eps, dist);
+#endif
+
+	for (k = 0; k < XYZ_BLOCK; ++ k) {
+		dist[k] = calc_dist(dat, i, index[k], 0);
+		if (dist[k] <= eps)
+			mask |= (1u << k);
+	}
+
+	return mask;
+}
+
+/*____________________________________________________________________________*/
+/* distance is a metric: Euclidean distance */
+int metric_dist(void){
+    return 1;
+}
+
+/*____________________________________________________________________________*/
+/* allocate the coordinate arrays for 'nAlloc' points */
+/* The three arrays are parts of one allocation, each aligned to XYZ_ALIGN. */
+void alloc_xyz(Dat *dat, int nAlloc)
+{
+	void *block = 0;
+	size_t stride = ((size_t)nAlloc * sizeof(float) + XYZ_ALIGN - 1) / XYZ_ALIGN * XYZ_ALIGN;
+
+	if (posix_memalign(&block, XYZ_ALIGN, (stride > 0) ? 3 * stride : XYZ_ALIGN) != 0) {
+		fprintf(stderr, "Error: Failed allocating %d points\n", nAlloc);
+		exit(1);
+	}
+	dat->x = (float *)block;
+	dat->y = (float *)((char *)block + stride);
+	dat->z = (float *)((char *)block + 2 * stride);
+}
+
+/*____________________________________________________________________________*/
+/* free the coordinate arrays */
+void free_xyz(Dat *dat)
+{
+	free(dat->x);
+	dat->x = 0;
+	dat->y = 0;
+	dat->z = 0;
+}
+
+/*____________________________________________________________________________*/
+/* parse data point 'item' from its line 'x y z' */
+static int parse_point(char *begin, char *end, int item, void *data)
+{
+	Dat *dat = (Dat *)data;
+	char *pos = begin;
+	char rest[2];
+
+	return (load_float(&pos, end, &(dat->x[item])) && load_float(&pos, end, &(dat->y[item])) &&
+			load_float(&pos, end, &(dat->z[item])) && (load_token(&pos, end, rest, sizeof(rest)) == 0));
+}
+
 /*____________________________________________________________________________*/
 /* read data points */
 /* Data points are expected to be an array of vectors in 3D with
- * coordinates 'x y z'. */
+ * coordinates 'x y z', one per line; blank lines are skipped.
+ * The file is parsed in chunks on several threads (load.c). */
 int get_data(char *inFileName, Dat *dat)
 {
-	FILE *inFile = 0;
-	unsigned int allocated = 64;
+	Load load;
+
+	load_open(&load, inFileName);
 
 	/* allocate memory */
-	dat->data = safe_malloc(allocated * sizeof(Vec));
+	dat->nData = load_count(&load, load_line_item);
+	alloc_xyz(dat, dat->nData + 1);
 
 	/* read data */
-	inFile = safe_open(inFileName, "r");
-
-	dat->nData = 0;
-	while(! feof(inFile)) {
-#ifdef DEBUG
-		++ n;
-		if (fscanf(inFile, "%f%f%f\n",
-				&(dat->data[dat->nData].x), &(dat->data[dat->nData].y), &(dat->data[dat->nData].z)) != 3) {
-			fprintf(stderr, "input data format has to be: [float] [float] [float]\n");
-			fprintf(stderr, "format error in line %d\n", n);
-			exit(1);
-		}
-#else
-		assert(fscanf(inFile, "%f%f%f\n",
-			&(dat->data[dat->nData].x), &(dat->data[dat->nData].y), &(dat->data[dat->nData].z)) == 3);
-#endif
-		++ dat->nData;
-
-		if (dat->nData == allocated) {
-			allocated += 64;
-			dat->data = safe_realloc(dat->data, allocated * sizeof(Vec));
-		}
-	}
+	load_parse(&load, parse_point, dat);
+	load_close(&load);
 
 	assert(dat->nData > 1);
 
-	fclose(inFile);
 	return 0;
 }
 
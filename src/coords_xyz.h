@@ -9,12 +9,21 @@ Read the COPYING file for license information.
 
 #include "arg.h"
 #include "config.h"
+#include "format.h"
+#include "load.h"
 #include "safe.h"
 #include "vector.h"
 
-/* input data */
+/* number of distances computed by one calc_dist_block() or calc_dist_gather() call */
+#define XYZ_BLOCK 8
+/* alignment of the coordinate arrays in bytes */
+#define XYZ_ALIGN 64
+
+/* input data: coordinates in separate aligned arrays */
 typedef struct {
-	Vec *data; /* input data to order */
+	float *x; /* x coordinates of the data points */
+	float *y; /* y coordinates of the data points */
+	float *z; /* z coordinates of the data points */
 	int nData; /* number of data points */
 } Dat;
 
@@ -22,7 +31,13 @@ typedef struct {
 /* prototypes */
 int get_data(char *inFileName, Dat *dat);
 float calc_dist(Dat *dat, int i, int j, Arg *arg);
+unsigned int calc_dist_block(Dat *dat, int i, int first, float eps, float *dist);
+unsigned int calc_dist_gather(Dat *dat, int i, int *index, float eps, float *dist);
+int metric_dist(void);
 void print_header_object(FILE *outfile);
-void print_object(FILE *outfile, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+char *format_object(char *s, Dat *dat, int index, int order, int cluster_id, float coreDist, float reachDist);
+int format_object_length(Dat *dat);
+void alloc_xyz(Dat *dat, int nAlloc);
+void free_xyz(Dat *dat);
 
 #endif
@@ -0,0 +1,127 @@
+/*==============================================================================
+format.c : output records formatted in parallel
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The records of an output file are formatted in blocks that fill a
+	buffer of FORMAT_BUFFER bytes (for records of the maximal length),
+	one block per thread at a time, and the blocks are written
+	in record order with one fwrite each. Numbers are formatted by hand
+	into the same characters as fprintf: a float times 1000 is exact as
+	double, so rounding it to the nearest integer (ties to even, as the
+	C library rounds exact decimal ties) gives the three decimals of
+	"%.3f". Values beyond the range of the integer conversion and
+	non-finite values are left to sprintf. */
+
+#include "format.h"
+
+/*____________________________________________________________________________*/
+/** right-align the 'n' characters 'digits' (in reverse order) in 'width',
+	followed by 'sep' */
+__inline__ static char *pad(char *s, char *digits, int n, int width, char sep)
+{
+	for (; width > n; -- width)
+		*(s ++) = ' ';
+	while (n > 0)
+		*(s ++) = digits[-- n];
+	*(s ++) = sep;
+
+	return s;
+}
+
+/*____________________________________________________________________________*/
+/** format 'value' as "%<width>d" followed by 'sep' at 's'; returns the end */
+char *format_int(char *s, int value, int width, char sep)
+{
+	char digits[FORMAT_INT];
+	unsigned int u = (value < 0) ? -(unsigned int)value : (unsigned int)value;
+	int n = 0;
+
+	do {
+		digits[n ++] = '0' + (u % 10);
+		u /= 10;
+	} while (u > 0);
+	if (value < 0)
+		digits[n ++] = '-';
+
+	return pad(s, digits, n, width, sep);
+}
+
+/*____________________________________________________________________________*/
+/** format 'value' as "%<width>.3f" followed by 'sep' at 's'; returns the end */
+char *format_float(char *s, float value, int width, char sep)
+{
+	char digits[FORMAT_FLOAT];
+	unsigned long long u;
+	int n = 0;
+
+	/* large and non-finite values */
+	if (! (fabs(value) < 1e15)) {
+		s += sprintf(s, "%*.3f", width, value);
+		*(s ++) = sep;
+		return s;
+	}
+
+	/* thousandths, rounded as by printf */
+	u = (unsigned long long)rint(fabs((double)value * 1000.));
+
+	digits[n ++] = '0' + (u % 10);
+	digits[n ++] = '0' + ((u / 10) % 10);
+	digits[n ++] = '0' + ((u / 100) % 10);
+	digits[n ++] = '.';
+	u /= 1000;
+	do {
+		digits[n ++] = '0' + (u % 10);
+		u /= 10;
+	} while (u > 0);
+	if (signbit(value))
+		digits[n ++] = '-';
+
+	return pad(s, digits, n, width, sep);
+}
+
+/*____________________________________________________________________________*/
+/** write 'n' records of 'data', each formatted by 'format' into at most
+	'maxLength' characters, to 'file' */
+void format_write(FILE *file, int n, int maxLength, FormatRecord format, void *data)
+{
+	int t; /* thread index */
+	int first; /* first record of the current round */
+	int nThread = 1;
+	int nBlock = (FORMAT_BUFFER / maxLength > 0) ? FORMAT_BUFFER / maxLength : 1; /* records per block */
+	char **buffer; /* formatted block of each thread */
+	int *length; /* length of each block */
+
+#ifdef _OPENMP
+	nThread = omp_get_max_threads();
+#endif
+	buffer = safe_malloc(nThread * sizeof(char *));
+	length = safe_malloc(nThread * sizeof(int));
+	for (t = 0; t < nThread; ++ t)
+		buffer[t] = safe_malloc((size_t)nBlock * maxLength * sizeof(char));
+
+	/* one block per thread and round */
+	for (first = 0; first < n; first += nThread * nBlock) {
+		#pragma omp parallel for schedule(static, 1) num_threads(nThread)
+		for (t = 0; t < nThread; ++ t) {
+			int i;
+			int begin = first + t * nBlock;
+			int end = (begin + nBlock < n) ? begin + nBlock : n;
+			char *s = buffer[t];
+
+			for (i = begin; i < end; ++ i)
+				s = format(s, i, data);
+			length[t] = s - buffer[t];
+		}
+
+		for (t = 0; (t < nThread) && (first + t * nBlock < n); ++ t)
+			fwrite(buffer[t], sizeof(char), length[t], file);
+	}
+
+	for (t = 0; t < nThread; ++ t)
+		free(buffer[t]);
+	free(buffer);
+	free(length);
+}
+
@@ -0,0 +1,37 @@
+/*==============================================================================
+format.h : output records formatted in parallel
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "config.h"
+#include "safe.h"
+
+/* maximal length of a formatted int ("%d" of INT_MIN) */
+#define FORMAT_INT 11
+/* maximal length of a formatted float ("%.3f" of -FLT_MAX) */
+#define FORMAT_FLOAT 44
+/* size of the buffer of one thread in bytes */
+#define FORMAT_BUFFER (1 << 22)
+
+/* format record i of 'data' at 's'; returns the end of the record */
+typedef char *(*FormatRecord)(char *s, int i, void *data);
+
+/*____________________________________________________________________________*/
+/* prototypes */
+char *format_int(char *s, int value, int width, char sep);
+char *format_float(char *s, float value, int width, char sep);
+void format_write(FILE *file, int n, int maxLength, FormatRecord format, void *data);
+
+#endif
@@ -0,0 +1,250 @@
+/*==============================================================================
+grid.c : hashed uniform grid (cell list) for range queries on point coordinates
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#include "grid.h"
+
+/* bits per axis in the packed cell key */
+#define KEYBITS 21
+#define MAXCELL ((1 << KEYBITS) - 2)
+
+/*____________________________________________________________________________*/
+/** test for periodic axis */
+__inline__ static int periodic(Grid *grid, int k)
+{
+	return ((grid->period != 0) && (grid->period[k] > 0.));
+}
+
+/*____________________________________________________________________________*/
+/** integer cell coordinate of value x along axis k */
+__inline__ static int cell_coord(Grid *grid, float x, int k)
+{
+	int c = (int)floor(((double)x - grid->lo[k]) / grid->edge[k]);
+
+	/* a periodic axis is closed: the upper boundary maps onto cell 0 */
+	if (periodic(grid, k) && (c >= grid->nCell[k]))
+		c -= grid->nCell[k];
+
+	return c;
+}
+
+/*____________________________________________________________________________*/
+/** distance along axis k; periodic axes wrap at half period */
+__inline__ static double axis_dist(Grid *grid, double d, int k)
+{
+	d = fabs(d);
+	if (periodic(grid, k) && (d > .5 * grid->period[k]))
+		d = grid->period[k] - d;
+
+	return d;
+}
+
+/*____________________________________________________________________________*/
+/** pack integer cell coordinates into one key */
+__inline__ static unsigned long long cell_key(Grid *grid, int *cell)
+{
+	int k;
+	unsigned long long key = 0;
+
+	for (k = 0; k < grid->dim; ++ k)
+		key = (key << KEYBITS) | (unsigned long long)cell[k];
+
+	return key;
+}
+
+/*____________________________________________________________________________*/
+/** hash slot of cell key (open addressing with linear probing);
+	returns the slot holding the key or the empty slot where it belongs */
+static int find_slot(Grid *grid, unsigned long long key)
+{
+	unsigned long long h = key;
+	int s;
+
+	/* 64-bit mixing function */
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+
+	for (s = (int)(h & (grid->nSlot - 1));
+		 (grid->slotStart[s] != -1) && (grid->slotKey[s] != key);
+		 s = (s + 1) & (grid->nSlot - 1));
+
+	return s;
+}
+
+/*____________________________________________________________________________*/
+/** build grid with cell edge 'edge' over 'nPt' points with 'dim' coordinates;
+	coordinates along a periodic axis must lie within one period;
+	the coordinate and period arrays are owned by the grid afterwards */
+void grid_build(Grid *grid, float *coord, float *period, int nPt, int dim, float edge)
+{
+	int i, k, s;
+	int cell[GRID_MAXDIM];
+	int *slot = safe_malloc(nPt * sizeof(int));
+	int *fill = 0;
+	float hi[GRID_MAXDIM];
+
+	assert(dim <= GRID_MAXDIM);
+
+	grid->dim = dim;
+	grid->nPt = nPt;
+	grid->coord = coord;
+	grid->period = period;
+
+	/* grid extent */
+	for (k = 0; k < dim; ++ k)
+		grid->lo[k] = hi[k] = coord[k];
+	for (i = 1; i < nPt; ++ i) {
+		for (k = 0; k < dim; ++ k) {
+			if (coord[i * dim + k] < grid->lo[k])
+				grid->lo[k] = coord[i * dim + k];
+			if (coord[i * dim + k] > hi[k])
+				hi[k] = coord[i * dim + k];
+		}
+	}
+
+	/* zero epsilon: points share a cell only if their coordinates are equal */
+	if (! (edge > 0.))
+		edge = FLT_MIN;
+
+	for (k = 0; k < dim; ++ k) {
+		grid->edge[k] = edge;
+		grid->nCell[k] = 0;
+		if (periodic(grid, k)) {
+			/* an integer number of cells, not smaller than 'edge', spans the period */
+			grid->nCell[k] = ((double)grid->period[k] / edge > MAXCELL) ?
+								MAXCELL : (int)(grid->period[k] / edge);
+			if (grid->nCell[k] < 1)
+				grid->nCell[k] = 1;
+			grid->edge[k] = (double)grid->period[k] / grid->nCell[k];
+		} else if (((double)hi[k] - grid->lo[k]) / edge > MAXCELL - 1) {
+			/* enlarge cells if the number of cells exceeds the key range;
+				larger cells keep the neighbour cell search complete */
+			grid->edge[k] = ((double)hi[k] - grid->lo[k]) / (MAXCELL - 1);
+		}
+	}
+
+	/* hash table with at least twice as many slots as points */
+	for (grid->nSlot = 64; grid->nSlot < 2 * nPt; grid->nSlot *= 2);
+	grid->slotKey = safe_malloc(grid->nSlot * sizeof(unsigned long long));
+	grid->slotStart = safe_malloc(grid->nSlot * sizeof(int));
+	grid->slotEnd = safe_malloc(grid->nSlot * sizeof(int));
+	for (s = 0; s < grid->nSlot; ++ s) {
+		grid->slotStart[s] = -1;
+		grid->slotEnd[s] = 0;
+	}
+
+	/* assign points to cells and count cell members */
+	for (i = 0; i < nPt; ++ i) {
+		for (k = 0; k < dim; ++ k)
+			cell[k] = cell_coord(grid, coord[i * dim + k], k);
+		s = find_slot(grid, cell_key(grid, cell));
+		grid->slotKey[s] = cell_key(grid, cell);
+		grid->slotStart[s] = 0;
+		++ grid->slotEnd[s];
+		slot[i] = s;
+	}
+
+	/* member ranges of cells */
+	for (s = 0, k = 0; s < grid->nSlot; ++ s) {
+		if (grid->slotStart[s] == -1)
+			continue;
+		grid->slotStart[s] = k;
+		k += grid->slotEnd[s];
+		grid->slotEnd[s] = grid->slotStart[s];
+	}
+
+	/* fill members in increasing point index */
+	grid->member = safe_malloc(nPt * sizeof(int));
+	fill = grid->slotEnd;
+	for (i = 0; i < nPt; ++ i)
+		grid->member[fill[slot[i]] ++] = i;
+
+	grid->removed = safe_malloc(nPt * sizeof(char));
+	for (i = 0; i < nPt; ++ i)
+		grid->removed[i] = 0;
+
+	free(slot);
+}
+
+/*____________________________________________________________________________*/
+/** collect all points within Euclidean 'radius' of 'query' in 'cand',
+	with wrapped differences along periodic axes;
+	'radius' must not exceed the cell edge; the candidate order is grid order;
+	returns the number of candidates */
+int grid_range(Grid *grid, float *query, float radius, int **cand, int *allocated)
+{
+	int k, m, n, s, i, offset, nOffset;
+	int nCand = 0;
+	int cell[GRID_MAXDIM], centre[GRID_MAXDIM], nVisit[GRID_MAXDIM];
+	double d, d2;
+	double radius2 = (double)radius * radius;
+
+	/* visit the 3^dim cells around the query cell;
+		periodic axes with less than 3 cells visit each cell once */
+	for (k = 0, nOffset = 1; k < grid->dim; ++ k) {
+		assert(radius <= grid->edge[k] * (1. + 1.e-9));
+		centre[k] = cell_coord(grid, query[k], k);
+		nVisit[k] = (periodic(grid, k) && (grid->nCell[k] < 3)) ? grid->nCell[k] : 3;
+		nOffset *= nVisit[k];
+	}
+
+	for (offset = 0; offset < nOffset; ++ offset) {
+		for (k = 0, n = offset; k < grid->dim; n /= nVisit[k], ++ k) {
+			cell[k] = centre[k] + (n % nVisit[k]) - ((nVisit[k] == 3) ? 1 : 0);
+			if (periodic(grid, k))
+				cell[k] = (cell[k] + grid->nCell[k]) % grid->nCell[k];
+			else if ((cell[k] < 0) || (cell[k] > MAXCELL))
+				break;
+		}
+		if (k < grid->dim)
+			continue;
+
+		s = find_slot(grid, cell_key(grid, cell));
+		if (grid->slotStart[s] == -1)
+			continue;
+
+		for (m = grid->slotStart[s]; m < grid->slotEnd[s]; ++ m) {
+			i = grid->member[m];
+			if (grid->removed[i])
+				continue;
+			for (k = 0, d2 = 0.; k < grid->dim; ++ k) {
+				d = axis_dist(grid, (double)grid->coord[i * grid->dim + k] - query[k], k);
+				d2 += d * d;
+			}
+			if (d2 <= radius2) {
+				(*cand)[nCand ++] = i;
+				/* allocate more space to candidate array if needed */
+				if (nCand == *allocated) {
+					*allocated += 64;
+					*cand = safe_realloc(*cand, *allocated * sizeof(int));
+				}
+			}
+		}
+	}
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** remove point i from all subsequent range searches */
+void grid_remove(Grid *grid, int i)
+{
+	grid->removed[i] = 1;
+}
+
+/*____________________________________________________________________________*/
+/** free grid memory */
+void grid_free(Grid *grid)
+{
+	free(grid->coord);
+	free(grid->period);
+	free(grid->slotKey);
+	free(grid->slotStart);
+	free(grid->slotEnd);
+	free(grid->member);
+	free(grid->removed);
+}
+
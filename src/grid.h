@@ -0,0 +1,47 @@
+/*==============================================================================
+grid.h : hashed uniform grid (cell list) for range queries on point coordinates
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef GRID_H
+#define GRID_H
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "safe.h"
+
+/* maximal dimension of grid coordinates */
+#define GRID_MAXDIM 3
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* uniform grid with cells hashed by their integer cell coordinates */
+typedef struct {
+	int dim; /* dimension of point coordinates */
+	int nPt; /* number of points */
+	float *coord; /* point coordinates: nPt * dim */
+	float *period; /* period of each axis, 0 for linear axes; may be 0 */
+	double edge[GRID_MAXDIM]; /* cell edge length along each axis */
+	float lo[GRID_MAXDIM]; /* lower corner of grid */
+	int nCell[GRID_MAXDIM]; /* number of cells along periodic axes */
+	unsigned long long *slotKey; /* cell key of each hash slot */
+	int *slotStart; /* first member of hash slot, -1 for empty slot */
+	int *slotEnd; /* one past the last member of hash slot */
+	int nSlot; /* number of hash slots (power of 2) */
+	int *member; /* point indices grouped by cell, increasing within a cell */
+	char *removed; /* flag for points removed from the grid */
+} Grid;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void grid_build(Grid *grid, float *coord, float *period, int nPt, int dim, float edge);
+int grid_range(Grid *grid, float *query, float radius, int **cand, int *allocated);
+void grid_remove(Grid *grid, int i);
+void grid_free(Grid *grid);
+
+#endif
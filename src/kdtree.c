@@ -0,0 +1,273 @@
+/*==============================================================================
+kdtree.c : k-d tree for range queries on point coordinates
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#include "kdtree.h"
+
+/* maximal number of points in a leaf node */
+#define LEAFSIZE 8
+
+/*____________________________________________________________________________*/
+/** coordinate of permuted point p along axis */
+__inline__ static float perm_coord(KdTree *tree, int p, int axis)
+{
+	return tree->coord[tree->perm[p] * tree->dim + axis];
+}
+
+/*____________________________________________________________________________*/
+/** distance along axis k; periodic axes wrap at half period */
+__inline__ static double axis_dist(KdTree *tree, double d, int k)
+{
+	d = fabs(d);
+	if ((tree->period != 0) && (tree->period[k] > 0.) && (d > .5 * tree->period[k]))
+		d = tree->period[k] - d;
+
+	return d;
+}
+
+/*____________________________________________________________________________*/
+/** swap two permutation entries */
+__inline__ static void swap_perm(int *perm, int a, int b)
+{
+	int tmp = perm[a];
+
+	perm[a] = perm[b];
+	perm[b] = tmp;
+}
+
+/*____________________________________________________________________________*/
+/** partial sort of perm[start,end) such that entry 'mid' is the median
+	along 'axis' (quickselect) */
+static void select_median(KdTree *tree, int start, int end, int mid, int axis)
+{
+	int l, r, i, j;
+	float pivot;
+
+	/* Hoare partition keeps runs of equal coordinates balanced */
+	l = start;
+	r = end - 1;
+	while (r > l) {
+		pivot = perm_coord(tree, l + (r - l) / 2, axis);
+		i = l;
+		j = r;
+		while (i <= j) {
+			while (perm_coord(tree, i, axis) < pivot)
+				++ i;
+			while (perm_coord(tree, j, axis) > pivot)
+				-- j;
+			if (i <= j) {
+				swap_perm(tree->perm, i, j);
+				++ i;
+				-- j;
+			}
+		}
+
+		if (mid <= j)
+			r = j;
+		else if (mid >= i)
+			l = i;
+		else
+			return;
+	}
+}
+
+/*____________________________________________________________________________*/
+/** recursively build node over perm[start,end) and return its index */
+static int build_node(KdTree *tree, int start, int end, int parent)
+{
+	int n, k, p, axis, mid;
+	float *lo, *hi;
+	float spread, maxSpread;
+
+	/* allocate more nodes if needed */
+	if (tree->nNode == tree->allocated) {
+		tree->allocated += 64;
+		tree->node = safe_realloc(tree->node, tree->allocated * sizeof(KdNode));
+		tree->box = safe_realloc(tree->box, tree->allocated * 2 * tree->dim * sizeof(float));
+	}
+
+	n = tree->nNode ++;
+	tree->node[n].start = start;
+	tree->node[n].end = end;
+	tree->node[n].left = -1;
+	tree->node[n].right = -1;
+	tree->node[n].parent = parent;
+	tree->node[n].nActive = end - start;
+
+	/* tight bounding box of node points */
+	lo = &(tree->box[n * 2 * tree->dim]);
+	hi = &(tree->box[n * 2 * tree->dim + tree->dim]);
+	for (k = 0; k < tree->dim; ++ k)
+		lo[k] = hi[k] = perm_coord(tree, start, k);
+	for (p = start + 1; p < end; ++ p) {
+		for (k = 0; k < tree->dim; ++ k) {
+			if (perm_coord(tree, p, k) < lo[k])
+				lo[k] = perm_coord(tree, p, k);
+			if (perm_coord(tree, p, k) > hi[k])
+				hi[k] = perm_coord(tree, p, k);
+		}
+	}
+
+	/* leaf node */
+	if ((end - start) <= LEAFSIZE) {
+		for (p = start; p < end; ++ p)
+			tree->leaf[tree->perm[p]] = n;
+		return n;
+	}
+
+	/* split along the axis of largest spread */
+	for (k = 0, axis = 0, maxSpread = -1.; k < tree->dim; ++ k) {
+		spread = hi[k] - lo[k];
+		if (spread > maxSpread) {
+			maxSpread = spread;
+			axis = k;
+		}
+	}
+
+	mid = start + (end - start) / 2;
+	select_median(tree, start, end, mid, axis);
+
+	/* the node array may be reallocated by the recursion: assign via index */
+	k = build_node(tree, start, mid, n);
+	tree->node[n].left = k;
+	k = build_node(tree, mid, end, n);
+	tree->node[n].right = k;
+
+	return n;
+}
+
+/*____________________________________________________________________________*/
+/** build tree over 'nPt' points with 'dim' coordinates each;
+	coordinates along a periodic axis must lie within one period;
+	the coordinate and period arrays are owned by the tree afterwards */
+void kdtree_build(KdTree *tree, float *coord, float *period, int nPt, int dim)
+{
+	int i;
+
+	tree->dim = dim;
+	tree->nPt = nPt;
+	tree->coord = coord;
+	tree->period = period;
+	tree->perm = safe_malloc(nPt * sizeof(int));
+	tree->leaf = safe_malloc(nPt * sizeof(int));
+	tree->removed = safe_malloc(nPt * sizeof(char));
+	tree->allocated = 64;
+	tree->node = safe_malloc(tree->allocated * sizeof(KdNode));
+	tree->box = safe_malloc(tree->allocated * 2 * dim * sizeof(float));
+	tree->nNode = 0;
+
+	for (i = 0; i < nPt; ++ i) {
+		tree->perm[i] = i;
+		tree->removed[i] = 0;
+	}
+
+	build_node(tree, 0, nPt, -1);
+}
+
+/*____________________________________________________________________________*/
+/** squared distance between query and bounding box of node n;
+	along periodic axes the box may be reached across the boundary */
+double kdtree_box_dist2(KdTree *tree, int n, float *query)
+{
+	int k;
+	double d, d2 = 0.;
+	float *lo = &(tree->box[n * 2 * tree->dim]);
+	float *hi = &(tree->box[n * 2 * tree->dim + tree->dim]);
+
+	for (k = 0; k < tree->dim; ++ k) {
+		if (query[k] < lo[k])
+			d = (double)lo[k] - query[k];
+		else if (query[k] > hi[k])
+			d = (double)query[k] - hi[k];
+		else
+			continue;
+		if ((tree->period != 0) && (tree->period[k] > 0.)) {
+			if (query[k] < lo[k])
+				d = fmin(d, (double)query[k] + tree->period[k] - hi[k]);
+			else
+				d = fmin(d, (double)lo[k] + tree->period[k] - query[k]);
+		}
+		d2 += d * d;
+	}
+
+	return d2;
+}
+
+/*____________________________________________________________________________*/
+/** recursive range search */
+static void range_node(KdTree *tree, int n, float *query, double radius2, int **cand, int *allocated, int *nCand)
+{
+	int p, i, k;
+	double d, d2;
+
+	if ((tree->node[n].nActive == 0) || (kdtree_box_dist2(tree, n, query) > radius2))
+		return;
+
+	if (tree->node[n].left >= 0) {
+		range_node(tree, tree->node[n].left, query, radius2, cand, allocated, nCand);
+		range_node(tree, tree->node[n].right, query, radius2, cand, allocated, nCand);
+		return;
+	}
+
+	/* leaf: test points */
+	for (p = tree->node[n].start; p < tree->node[n].end; ++ p) {
+		i = tree->perm[p];
+		if (tree->removed[i])
+			continue;
+		for (k = 0, d2 = 0.; k < tree->dim; ++ k) {
+			d = axis_dist(tree, (double)tree->coord[i * tree->dim + k] - query[k], k);
+			d2 += d * d;
+		}
+		if (d2 <= radius2) {
+			(*cand)[(*nCand) ++] = i;
+			/* allocate more space to candidate array if needed */
+			if (*nCand == *allocated) {
+				*allocated += 64;
+				*cand = safe_realloc(*cand, *allocated * sizeof(int));
+			}
+		}
+	}
+}
+
+/*____________________________________________________________________________*/
+/** collect all points within Euclidean 'radius' of 'query' in 'cand',
+	with wrapped differences along periodic axes;
+	the candidate order is tree order; returns the number of candidates */
+int kdtree_range(KdTree *tree, float *query, float radius, int **cand, int *allocated)
+{
+	int nCand = 0;
+
+	range_node(tree, 0, query, (double)radius * radius, cand, allocated, &nCand);
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** remove point i from all subsequent range searches */
+void kdtree_remove(KdTree *tree, int i)
+{
+	int n;
+
+	if (tree->removed[i])
+		return;
+	tree->removed[i] = 1;
+
+	for (n = tree->leaf[i]; n >= 0; n = tree->node[n].parent)
+		-- tree->node[n].nActive;
+}
+
+/*____________________________________________________________________________*/
+/** free tree memory */
+void kdtree_free(KdTree *tree)
+{
+	free(tree->coord);
+	free(tree->period);
+	free(tree->perm);
+	free(tree->leaf);
+	free(tree->removed);
+	free(tree->node);
+	free(tree->box);
+}
+
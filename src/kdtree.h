@@ -0,0 +1,53 @@
+/*==============================================================================
+kdtree.h : k-d tree for range queries on point coordinates
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "safe.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* tree node */
+typedef struct {
+	int start; /* first entry of node in the permutation array */
+	int end; /* one past the last entry of node in the permutation array */
+	int left; /* left child node, -1 for leaf */
+	int right; /* right child node, -1 for leaf */
+	int parent; /* parent node, -1 for root */
+	int nActive; /* number of points not yet removed from node */
+} KdNode;
+
+/* k-d tree */
+typedef struct {
+	int dim; /* dimension of point coordinates */
+	int nPt; /* number of points */
+	float *coord; /* point coordinates: nPt * dim */
+	float *period; /* period of each axis, 0 for linear axes; may be 0 */
+	int *perm; /* point indices in tree order */
+	int *leaf; /* leaf node of each point */
+	char *removed; /* flag for points removed from the tree */
+	KdNode *node; /* tree nodes */
+	float *box; /* node bounding boxes: nNode * 2 * dim (low, high) */
+	int nNode; /* number of nodes */
+	int allocated; /* allocated nodes */
+} KdTree;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void kdtree_build(KdTree *tree, float *coord, float *period, int nPt, int dim);
+int kdtree_range(KdTree *tree, float *query, float radius, int **cand, int *allocated);
+double kdtree_box_dist2(KdTree *tree, int n, float *query);
+void kdtree_remove(KdTree *tree, int i);
+void kdtree_free(KdTree *tree);
+
+#endif
@@ -0,0 +1,236 @@
+/*==============================================================================
+load.c : input files parsed in chunks on several threads
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The input file is mapped into memory (or read in one piece if it cannot
+	be mapped) and split into chunks of about LOAD_CHUNK bytes that end at
+	line ends. A first parallel pass counts the lines and items (data points
+	or values) of each chunk; the sums over the preceding chunks give the
+	index of the first item of each chunk, so that the second parallel pass
+	parses every line into its place in the data arrays. The items are
+	therefore in file order, as with a serial read. */
+
+#include "load.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*____________________________________________________________________________*/
+/** separator between the items of a line */
+__inline__ static int is_separator(char c)
+{
+	return ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f'));
+}
+
+/*____________________________________________________________________________*/
+/** end of the line starting at 'begin' in a chunk ending at 'chunkEnd' */
+__inline__ static char *line_end(char *begin, char *chunkEnd)
+{
+	char *end = memchr(begin, '\n', chunkEnd - begin);
+
+	return ((end != 0) ? end : chunkEnd);
+}
+
+/*____________________________________________________________________________*/
+/** map or read the input file and split it into chunks */
+void load_open(Load *load, char *inFileName)
+{
+	FILE *inFile = safe_open(inFileName, "r");
+	size_t allocated = LOAD_CHUNK;
+	size_t pos, next, n;
+	char *lineEnd;
+#ifdef HAVE_SYS_MMAN_H
+	struct stat fileStat;
+#endif
+
+	load->fileName = inFileName;
+	load->text = 0;
+	load->size = 0;
+	load->mapped = 0;
+	load->count = 0;
+
+#ifdef HAVE_SYS_MMAN_H
+	/* map regular files */
+	if ((fstat(fileno(inFile), &fileStat) == 0) && S_ISREG(fileStat.st_mode) && (fileStat.st_size > 0)) {
+		load->text = mmap(0, fileStat.st_size, PROT_READ, MAP_PRIVATE, fileno(inFile), 0);
+		if (load->text != MAP_FAILED) {
+			load->size = fileStat.st_size;
+			load->mapped = 1;
+		}
+	}
+#endif
+
+	/* read other files in one piece */
+	if (! load->mapped) {
+		load->text = safe_malloc(allocated * sizeof(char));
+		while ((n = fread(&(load->text[load->size]), sizeof(char), allocated - load->size, inFile)) > 0) {
+			load->size += n;
+			if (load->size == allocated) {
+				allocated *= 2;
+				load->text = safe_realloc(load->text, allocated * sizeof(char));
+			}
+		}
+	}
+
+	fclose(inFile);
+
+	/* chunks end at the first line end after LOAD_CHUNK bytes */
+	load->chunkStart = safe_malloc((load->size / LOAD_CHUNK + 2) * sizeof(size_t));
+	for (pos = 0, load->nChunk = 0; pos < load->size; pos = next) {
+		load->chunkStart[load->nChunk ++] = pos;
+		next = pos + LOAD_CHUNK;
+		if (next >= load->size) {
+			next = load->size;
+		} else {
+			lineEnd = memchr(&(load->text[next - 1]), '\n', load->size - next + 1);
+			next = (lineEnd != 0) ? (lineEnd - load->text + 1) : load->size;
+		}
+	}
+	load->chunkStart[load->nChunk] = load->size;
+
+	load->firstLine = safe_malloc((load->nChunk + 1) * sizeof(int));
+	load->firstItem = safe_malloc((load->nChunk + 1) * sizeof(int));
+	load->nItem = 0;
+}
+
+/*____________________________________________________________________________*/
+/** count the items of all lines with 'count'; returns the number of items */
+int load_count(Load *load, LoadCount count)
+{
+	int c;
+
+	load->count = count;
+
+	/* lines and items of each chunk */
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (c = 0; c < load->nChunk; ++ c) {
+		char *chunkEnd = &(load->text[load->chunkStart[c + 1]]);
+		char *begin, *end;
+		int nLine = 0;
+		int nItem = 0;
+
+		for (begin = &(load->text[load->chunkStart[c]]); begin < chunkEnd; begin = end + 1) {
+			end = line_end(begin, chunkEnd);
+			nItem += count(begin, end);
+			++ nLine;
+		}
+		load->firstLine[c + 1] = nLine;
+		load->firstItem[c + 1] = nItem;
+	}
+
+	/* lines and items before each chunk */
+	load->firstLine[0] = 0;
+	load->firstItem[0] = 0;
+	for (c = 0; c < load->nChunk; ++ c) {
+		load->firstLine[c + 1] += load->firstLine[c];
+		load->firstItem[c + 1] += load->firstItem[c];
+	}
+	load->nItem = load->firstItem[load->nChunk];
+
+	return load->nItem;
+}
+
+/*____________________________________________________________________________*/
+/** parse all lines with items (as counted by load_count()) into 'data' */
+void load_parse(Load *load, LoadParse parse, void *data)
+{
+	int c;
+	int errorLine = 0; /* first line with a format error */
+
+	assert(load->count != 0);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (c = 0; c < load->nChunk; ++ c) {
+		char *chunkEnd = &(load->text[load->chunkStart[c + 1]]);
+		char *begin, *end;
+		int line = load->firstLine[c];
+		int item = load->firstItem[c];
+		int nItem;
+
+		for (begin = &(load->text[load->chunkStart[c]]); begin < chunkEnd; begin = end + 1) {
+			end = line_end(begin, chunkEnd);
+			++ line;
+			if ((nItem = load->count(begin, end)) == 0)
+				continue;
+			if (! parse(begin, end, item, data)) {
+				#pragma omp critical (load_error)
+				if ((errorLine == 0) || (line < errorLine))
+					errorLine = line;
+				break;
+			}
+			item += nItem;
+		}
+	}
+
+	if (errorLine > 0) {
+		fprintf(stderr, "Error: format error in line %d of file '%s'\n", errorLine, load->fileName);
+		exit(1);
+	}
+}
+
+/*____________________________________________________________________________*/
+/** unmap or free the file contents */
+void load_close(Load *load)
+{
+#ifdef HAVE_SYS_MMAN_H
+	if (load->mapped)
+		munmap(load->text, load->size);
+	else
+#endif
+		free(load->text);
+	free(load->chunkStart);
+	free(load->firstLine);
+	free(load->firstItem);
+}
+
+/*____________________________________________________________________________*/
+/** count for files with one item per line: 1 unless the line is blank */
+int load_line_item(char *begin, char *end)
+{
+	for (; begin < end; ++ begin)
+		if (! is_separator(*begin))
+			return 1;
+
+	return 0;
+}
+
+/*____________________________________________________________________________*/
+/** copy the next item of the line [*pos, end) into 'token' (of 'size'
+	bytes, terminated) and move *pos behind it; returns the item length,
+	0 at the line end and -1 if the item does not fit */
+int load_token(char **pos, char *end, char *token, int size)
+{
+	int n = 0;
+
+	while ((*pos < end) && is_separator(**pos))
+		++ (*pos);
+
+	for (; (*pos < end) && (! is_separator(**pos)); ++ (*pos)) {
+		if (n < size - 1)
+			token[n] = **pos;
+		++ n;
+	}
+	token[(n < size - 1) ? n : (size - 1)] = '\0';
+
+	return ((n < size) ? n : -1);
+}
+
+/*____________________________________________________________________________*/
+/** read the next item of the line [*pos, end) as float (as fscanf '%f');
+	returns 0 if there is none or it is not a number */
+int load_float(char **pos, char *end, float *value)
+{
+	char token[64];
+	char *tokenEnd;
+
+	if (load_token(pos, end, token, sizeof(token)) <= 0)
+		return 0;
+	*value = strtof(token, &tokenEnd);
+
+	return (*tokenEnd == '\0');
+}
+
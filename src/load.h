@@ -0,0 +1,57 @@
+/*==============================================================================
+load.h : input files parsed in chunks on several threads
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef LOAD_H
+#define LOAD_H
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "config.h"
+#include "safe.h"
+
+/* chunk size in bytes; chunks end at line ends */
+#define LOAD_CHUNK (1 << 20)
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* number of items in the line [begin, end) */
+typedef int (*LoadCount)(char *begin, char *end);
+/* parse the line [begin, end), whose first item is 'item' of all items,
+	into 'data'; returns 0 on a format error */
+typedef int (*LoadParse)(char *begin, char *end, int item, void *data);
+
+/* input file split into chunks of whole lines */
+typedef struct {
+	char *text; /* file contents */
+	size_t size; /* file size */
+	int mapped; /* 1: 'text' is mapped, 0: 'text' is allocated */
+	int nChunk; /* number of chunks */
+	size_t *chunkStart; /* offset of each chunk, then the file size */
+	int *firstLine; /* number of lines before each chunk */
+	int *firstItem; /* number of items before each chunk */
+	int nItem; /* number of items of all lines */
+	LoadCount count; /* item count of a line */
+	char *fileName; /* file name for error messages */
+} Load;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void load_open(Load *load, char *inFileName);
+int load_count(Load *load, LoadCount count);
+void load_parse(Load *load, LoadParse parse, void *data);
+void load_close(Load *load);
+int load_line_item(char *begin, char *end);
+int load_token(char **pos, char *end, char *token, int size);
+int load_float(char **pos, char *end, float *value);
+
+#endif
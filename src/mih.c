@@ -0,0 +1,159 @@
+/*==============================================================================
+mih.c : multi-index hashing for windowed Hamming distance queries on strings
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The distance of two strings of equal length is the number of window
+	positions at which their windows of width w differ. The window
+	positions are split into nSeg contiguous segments. If the distance
+	is below nSeg, at least one segment has no mismatching window
+	(pigeonhole principle), i.e. both strings share the substring that
+	covers all windows of this segment. Strings are hashed by these
+	substrings, one hash table per segment; the union of the buckets of
+	a query string contains all its neighbours. */
+
+#include "mih.h"
+
+/*____________________________________________________________________________*/
+/** hash value of string segment (64-bit FNV-1a) */
+__inline__ static unsigned long long hash_segment(char *s, int len)
+{
+	int k;
+	unsigned long long h = 0xcbf29ce484222325ULL;
+
+	for (k = 0; k < len; ++ k) {
+		h ^= (unsigned char)s[k];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/*____________________________________________________________________________*/
+/* hash value and string index */
+typedef struct {
+	unsigned long long h;
+	int i;
+} Hashed;
+
+/*____________________________________________________________________________*/
+/** hash value a before b */
+__inline__ static int before_hashed(Hashed a, Hashed b)
+{
+	return (a.h < b.h);
+}
+
+/* sort hash values */
+MERGESORT_DEFINE(sort_hashed, Hashed, before_hashed)
+
+/*____________________________________________________________________________*/
+/** build hash tables over 'nPt' strings of length 'len' for window width 'w';
+	the 'len - w + 1' window positions are split into 'nSeg' segments,
+	nSeg must not exceed the number of window positions */
+void mih_build(Mih *mih, char **str, int nPt, int len, int w, int nSeg)
+{
+	int i, s, m, first, last;
+	int nWin = len - w + 1;
+	Hashed *hashed = safe_malloc(nPt * sizeof(Hashed));
+
+	mih->nPt = nPt;
+	mih->nSeg = nSeg;
+	mih->nBucket = 0;
+	mih->member = safe_malloc(nPt * nSeg * sizeof(int));
+	mih->bucketStart = safe_malloc(nPt * nSeg * sizeof(int));
+	mih->bucketEnd = safe_malloc(nPt * nSeg * sizeof(int));
+	mih->bucket = safe_malloc(nPt * nSeg * sizeof(int));
+	mih->removed = safe_malloc(nPt * sizeof(char));
+	mih->mark = safe_malloc(nPt * sizeof(int));
+	mih->nQuery = 0;
+
+	for (i = 0; i < nPt; ++ i) {
+		mih->removed[i] = 0;
+		mih->mark[i] = 0;
+	}
+
+	for (s = 0, m = 0; s < nSeg; ++ s) {
+		/* segment s covers window positions [first,last),
+			i.e. characters [first,last+w-1) */
+		first = (int)((long long)s * nWin / nSeg);
+		last = (int)((long long)(s + 1) * nWin / nSeg);
+
+		for (i = 0; i < nPt; ++ i) {
+			hashed[i].h = hash_segment(&(str[i][first]), last - first + w - 1);
+			hashed[i].i = i;
+		}
+		/* stable sort: bucket members remain in index order */
+		sort_hashed(hashed, nPt);
+
+		/* runs of equal hash values form the buckets of this segment */
+		for (i = 0; i < nPt; ++ i, ++ m) {
+			if ((i == 0) || (hashed[i].h != hashed[i - 1].h)) {
+				if (mih->nBucket > 0)
+					mih->bucketEnd[mih->nBucket - 1] = m;
+				mih->bucketStart[mih->nBucket ++] = m;
+			}
+			mih->member[m] = hashed[i].i;
+			mih->bucket[hashed[i].i * nSeg + s] = mih->nBucket - 1;
+		}
+	}
+	mih->bucketEnd[mih->nBucket - 1] = m;
+
+	free(hashed);
+}
+
+/*____________________________________________________________________________*/
+/** collect all strings sharing a segment with string i in 'cand';
+	the candidate order is bucket order; returns the number of candidates */
+int mih_range(Mih *mih, int i, int **cand, int *allocated)
+{
+	int s, b, m, j;
+	int nCand = 0;
+
+	++ mih->nQuery;
+
+	for (s = 0; s < mih->nSeg; ++ s) {
+		b = mih->bucket[i * mih->nSeg + s];
+		for (m = mih->bucketStart[b]; m < mih->bucketEnd[b]; ++ m) {
+			j = mih->member[m];
+			/* drop removed strings from the bucket for later queries */
+			while (mih->removed[j] && (m < mih->bucketEnd[b])) {
+				mih->member[m] = mih->member[-- mih->bucketEnd[b]];
+				mih->member[mih->bucketEnd[b]] = j;
+				j = mih->member[m];
+			}
+			if ((m == mih->bucketEnd[b]) || (mih->mark[j] == mih->nQuery))
+				continue;
+			mih->mark[j] = mih->nQuery;
+
+			(*cand)[nCand ++] = j;
+			/* allocate more space to candidate array if needed */
+			if (nCand == *allocated) {
+				*allocated += 64;
+				*cand = safe_realloc(*cand, *allocated * sizeof(int));
+			}
+		}
+	}
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** remove string i from all subsequent range searches */
+void mih_remove(Mih *mih, int i)
+{
+	mih->removed[i] = 1;
+}
+
+/*____________________________________________________________________________*/
+/** free hash memory */
+void mih_free(Mih *mih)
+{
+	free(mih->member);
+	free(mih->bucketStart);
+	free(mih->bucketEnd);
+	free(mih->bucket);
+	free(mih->removed);
+	free(mih->mark);
+}
+
@@ -0,0 +1,42 @@
+/*==============================================================================
+mih.h : multi-index hashing for windowed Hamming distance queries on strings
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef MIH_H
+#define MIH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "safe.h"
+#include "sort.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* multi-index hash */
+typedef struct {
+	int nPt; /* number of strings */
+	int nSeg; /* number of segments (hash tables) */
+	int nBucket; /* number of buckets over all segments */
+	int *member; /* strings of all buckets, grouped by bucket */
+	int *bucketStart; /* first member of bucket */
+	int *bucketEnd; /* one past the last active member of bucket */
+	int *bucket; /* bucket of each string in each segment: nPt * nSeg */
+	char *removed; /* flag for strings removed from the index */
+	int *mark; /* last query that collected each string */
+	int nQuery; /* number of queries */
+} Mih;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void mih_build(Mih *mih, char **str, int nPt, int len, int w, int nSeg);
+int mih_range(Mih *mih, int i, int **cand, int *allocated);
+void mih_remove(Mih *mih, int i);
+void mih_free(Mih *mih);
+
+#endif
+
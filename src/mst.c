@@ -0,0 +1,469 @@
+/*==============================================================================
+mst.c : OPTICS ordering from a minimum spanning tree over mutual reachability
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The mutual reachability distance of points p and q is
+	max(CD(p), CD(q), d(p,q)), with core distances over all data points.
+	Prim's algorithm on the graph of mutual reachability distances
+	visits the points in the order of a (symmetric) OPTICS ordering,
+	with the weight of the connecting edge as reachability distance.
+	The same ordering follows from the minimum spanning tree alone,
+	which is built here with Boruvka's algorithm: in each round every
+	component adds its lightest edge to another component. The search
+	for these edges is independent per point and runs in parallel;
+	for point coordinates it is pruned with a k-d tree. */
+
+#include "mst.h"
+
+/* Distances computed by calc_dist() may differ from the coordinate
+	distances of the k-d tree by rounding; lower bounds from bounding
+	boxes are reduced by a relative SLACK. */
+#define SLACK 1.0e-5
+
+extern int silent;
+
+/*____________________________________________________________________________*/
+/* search state of the Boruvka engine */
+typedef struct {
+	Dat *dat; /* input data */
+	Par *par; /* ordering parameters */
+	Arg *arg; /* arguments for calc_dist() */
+	float *coreDist; /* core distances over all data points */
+	int *comp; /* component (root point) of each point */
+	KdTree *tree; /* k-d tree over point coordinates, 0 if not available */
+	int *nodeComp; /* component of all points of a tree node, -1 if mixed */
+	float *compBound; /* weight of the lightest edge found for each component */
+} Mst;
+
+/*____________________________________________________________________________*/
+/** edge order: by weight, then by point indices */
+__inline__ static int before_edge(MstEdge *x, MstEdge *y)
+{
+	return ((x->w < y->w) ||
+			((x->w == y->w) && ((x->a < y->a) || ((x->a == y->a) && (x->b < y->b)))));
+}
+
+/*____________________________________________________________________________*/
+/** lower bound of calc_dist() between point p and the points of node n */
+__inline__ static float node_bound(Mst *mst, int n, int p)
+{
+	return (float)(sqrt(kdtree_box_dist2(mst->tree, n, &(mst->tree->coord[p * mst->tree->dim]))) * (1. - SLACK));
+}
+
+/*____________________________________________________________________________*/
+/** collect the minPts nearest neighbours of p among the points of node n */
+static void knn_node(Mst *mst, int n, int p, Epsn *heap, int *nHeap)
+{
+	int k, q, first, second;
+	Epsn neigh;
+	KdNode *node = &(mst->tree->node[n]);
+
+	if ((*nHeap == mst->par->minPts) && (node_bound(mst, n, p) > heap[0].dist))
+		return;
+	if (node_bound(mst, n, p) > mst->par->eps)
+		return;
+
+	if (node->left < 0) {
+		for (k = node->start; k < node->end; ++ k) {
+			if ((q = mst->tree->perm[k]) == p)
+				continue;
+			neigh.index = q;
+			if ((neigh.dist = calc_dist(mst->dat, p, q, mst->arg)) <= mst->par->eps)
+				neighbour_heap_push(heap, nHeap, mst->par->minPts, neigh);
+		}
+		return;
+	}
+
+	/* closer child first */
+	first = node->left;
+	second = node->right;
+	if (node_bound(mst, second, p) < node_bound(mst, first, p)) {
+		first = node->right;
+		second = node->left;
+	}
+	knn_node(mst, first, p, heap, nHeap);
+	knn_node(mst, second, p, heap, nHeap);
+}
+
+/*____________________________________________________________________________*/
+/** core distances over all data points: distance of the minPts-th
+	neighbour within epsilon, otherwise undefined (eps + 1);
+	'core' (if not 0) flags the points with a defined core distance */
+static void core_distances(Mst *mst, char *core)
+{
+	int p, q, nHeap;
+	Epsn neigh;
+	Epsn *heap = 0;
+
+	#pragma omp parallel private(p, q, nHeap, neigh, heap)
+	{
+		heap = safe_malloc(mst->par->minPts * sizeof(Epsn));
+
+		#pragma omp for schedule(dynamic, 64)
+		for (p = 0; p < mst->dat->nData; ++ p) {
+			nHeap = 0;
+			if (mst->tree != 0) {
+				knn_node(mst, 0, p, heap, &nHeap);
+			} else {
+				for (q = 0; q < mst->dat->nData; ++ q) {
+					if (q == p)
+						continue;
+					neigh.index = q;
+					if ((neigh.dist = calc_dist(mst->dat, p, q, mst->arg)) <= mst->par->eps)
+						neighbour_heap_push(heap, &nHeap, mst->par->minPts, neigh);
+				}
+			}
+			mst->coreDist[p] = (nHeap == mst->par->minPts) ?
+								heap[0].dist : mst->par->eps + 1.0;
+			if (core != 0)
+				core[p] = (nHeap == mst->par->minPts);
+		}
+
+		free(heap);
+	}
+}
+
+/*____________________________________________________________________________*/
+/** upper bound of the lightest outgoing edge of the component of p:
+	edges above the bound cannot be selected for the component */
+__inline__ static float edge_bound(Mst *mst, int p, MstEdge *best)
+{
+	float bound;
+
+	/* updated by other threads (see boruvka) */
+	#pragma omp atomic read
+	bound = mst->compBound[mst->comp[p]];
+
+	if ((best->a >= 0) && (best->w < bound))
+		bound = best->w;
+
+	return bound;
+}
+
+/*____________________________________________________________________________*/
+/** test edge p-q and keep it if it is lighter than 'best' */
+__inline__ static void test_edge(Mst *mst, int p, int q, MstEdge *best)
+{
+	MstEdge edge;
+	float dist;
+
+	/* the core distances bound the mutual reachability from below */
+	edge.w = (mst->coreDist[p] > mst->coreDist[q]) ? mst->coreDist[p] : mst->coreDist[q];
+	if (edge.w > edge_bound(mst, p, best))
+		return;
+
+	if ((dist = calc_dist(mst->dat, p, q, mst->arg)) > edge.w)
+		edge.w = dist;
+	if (! (edge.w <= mst->par->eps))
+		return;
+
+	edge.a = (p < q) ? p : q;
+	edge.b = (p < q) ? q : p;
+	if ((best->a < 0) || before_edge(&edge, best))
+		*best = edge;
+}
+
+/*____________________________________________________________________________*/
+/** lightest edge from p to another component among the points of node n */
+static void nearest_node(Mst *mst, int n, int p, MstEdge *best)
+{
+	int k, first, second;
+	float bound;
+	KdNode *node = &(mst->tree->node[n]);
+
+	if (mst->nodeComp[n] == mst->comp[p])
+		return;
+	bound = node_bound(mst, n, p);
+	if (bound < mst->coreDist[p])
+		bound = mst->coreDist[p];
+	if (bound > edge_bound(mst, p, best))
+		return;
+
+	if (node->left < 0) {
+		for (k = node->start; k < node->end; ++ k)
+			if (mst->comp[mst->tree->perm[k]] != mst->comp[p])
+				test_edge(mst, p, mst->tree->perm[k], best);
+		return;
+	}
+
+	/* closer child first */
+	first = node->left;
+	second = node->right;
+	if (node_bound(mst, second, p) < node_bound(mst, first, p)) {
+		first = node->right;
+		second = node->left;
+	}
+	nearest_node(mst, first, p, best);
+	nearest_node(mst, second, p, best);
+}
+
+/*____________________________________________________________________________*/
+/** component of all points of each tree node, -1 if mixed;
+	child nodes have higher indices than their parent */
+static void node_components(Mst *mst)
+{
+	int n, k;
+	KdNode *node = 0;
+
+	for (n = mst->tree->nNode - 1; n >= 0; -- n) {
+		node = &(mst->tree->node[n]);
+		if (node->left < 0) {
+			mst->nodeComp[n] = mst->comp[mst->tree->perm[node->start]];
+			for (k = node->start + 1; k < node->end; ++ k)
+				if (mst->comp[mst->tree->perm[k]] != mst->nodeComp[n])
+					mst->nodeComp[n] = -1;
+		} else {
+			mst->nodeComp[n] = (mst->nodeComp[node->left] == mst->nodeComp[node->right]) ?
+								mst->nodeComp[node->left] : -1;
+		}
+	}
+}
+
+/*____________________________________________________________________________*/
+/** root of the component of point p (union-find with path halving) */
+static int find_root(int *parent, int p)
+{
+	while (parent[p] != p) {
+		parent[p] = parent[parent[p]];
+		p = parent[p];
+	}
+
+	return p;
+}
+
+/*____________________________________________________________________________*/
+/** minimum spanning forest by Boruvka's algorithm; returns number of edges */
+static int boruvka(Mst *mst, MstEdge *edge)
+{
+	int p, q, r, round, nEdge = 0, nAdded;
+	float bound;
+	int nPt = mst->dat->nData;
+	int *parent = safe_malloc(nPt * sizeof(int));
+	MstEdge *best = safe_malloc(nPt * sizeof(MstEdge));
+	MstEdge *compBest = safe_malloc(nPt * sizeof(MstEdge));
+
+	for (p = 0; p < nPt; ++ p)
+		parent[p] = p;
+
+	for (round = 1, nAdded = 1; (nAdded > 0) && (nEdge < nPt - 1); ++ round) {
+		for (p = 0; p < nPt; ++ p) {
+			mst->comp[p] = find_root(parent, p);
+			mst->compBound[p] = mst->par->eps;
+			compBest[p].a = -1;
+		}
+		if (mst->tree != 0)
+			node_components(mst);
+
+		/* lightest outgoing edge of each point */
+		#pragma omp parallel for private(q, bound) schedule(dynamic, 64)
+		for (p = 0; p < nPt; ++ p) {
+			best[p].a = -1;
+			if (mst->tree != 0) {
+				nearest_node(mst, 0, p, &(best[p]));
+			} else {
+				for (q = 0; q < nPt; ++ q)
+					if (mst->comp[q] != mst->comp[p])
+						test_edge(mst, p, q, &(best[p]));
+			}
+			/* share the bound with the other points of the component;
+				pruning is strict, so equal edges are still found;
+				the bounds are read atomically and written atomically
+				inside the critical section, which orders the updates */
+			if (best[p].a >= 0) {
+				#pragma omp atomic read
+				bound = mst->compBound[mst->comp[p]];
+				if (best[p].w < bound) {
+					#pragma omp critical (compbound)
+					if (best[p].w < mst->compBound[mst->comp[p]]) {
+						#pragma omp atomic write
+						mst->compBound[mst->comp[p]] = best[p].w;
+					}
+				}
+			}
+		}
+
+		/* lightest outgoing edge of each component */
+		for (p = 0; p < nPt; ++ p) {
+			r = mst->comp[p];
+			if ((best[p].a >= 0) && ((compBest[r].a < 0) || before_edge(&(best[p]), &(compBest[r]))))
+				compBest[r] = best[p];
+		}
+
+		/* merge components; a strict edge order excludes cycles */
+		for (r = 0, nAdded = 0; r < nPt; ++ r) {
+			if (compBest[r].a < 0)
+				continue;
+			p = find_root(parent, compBest[r].a);
+			q = find_root(parent, compBest[r].b);
+			if (p == q)
+				continue;
+			parent[(p < q) ? q : p] = (p < q) ? p : q;
+			edge[nEdge ++] = compBest[r];
+			++ nAdded;
+		}
+
+		if (! silent)
+			fprintf(stderr, "Boruvka round %d: %d tree edges\n", round, nEdge);
+	}
+
+	free(parent);
+	free(best);
+	free(compBest);
+
+	return nEdge;
+}
+
+/*____________________________________________________________________________*/
+/** order points by Prim's traversal of the spanning forest from point 0:
+	the next point is the one with the lightest edge to the visited points
+	and the edge weight is its reachability distance; a new tree of the
+	forest starts at the lowest unvisited index with undefined RD (eps) */
+static void traverse(Par *par, OpticsDat *opticsdat, Pt **ordered_data, MstEdge *edge, int nEdge)
+{
+	int e, k, p, q, o, next;
+	int nPt = opticsdat->nPt;
+	int *start = safe_malloc((nPt + 1) * sizeof(int));
+	int *adj = safe_malloc(2 * nEdge * sizeof(int));
+	float *weight = safe_malloc(2 * nEdge * sizeof(float));
+	SeedList seeds;
+
+	/* adjacency lists of the forest */
+	for (p = 0; p <= nPt; ++ p)
+		start[p] = 0;
+	for (e = 0; e < nEdge; ++ e) {
+		++ start[edge[e].a + 1];
+		++ start[edge[e].b + 1];
+	}
+	for (p = 0; p < nPt; ++ p)
+		start[p + 1] += start[p];
+	for (e = 0; e < nEdge; ++ e) {
+		k = start[edge[e].a] ++;
+		adj[k] = edge[e].b;
+		weight[k] = edge[e].w;
+		k = start[edge[e].b] ++;
+		adj[k] = edge[e].a;
+		weight[k] = edge[e].w;
+	}
+	for (p = nPt; p > 0; -- p)
+		start[p] = start[p - 1];
+	start[0] = 0;
+
+	seedlist_init(&seeds, nPt);
+
+	for (o = 0, next = 0; o < nPt; ++ o) {
+		if ((p = seedlist_pop(&seeds)) >= 0) {
+			opticsdat->pt[p].reachDist = seeds.key[p];
+		} else {
+			/* first point of a new tree */
+			while (opticsdat->pt[next].processed > 0)
+				++ next;
+			p = next;
+			opticsdat->pt[p].reachDist = par->eps;
+		}
+
+		++ opticsdat->pt[p].processed;
+		opticsdat->pt[p].index = p;
+		opticsdat->pt[p].order = o;
+		ordered_data[o] = &(opticsdat->pt[p]);
+
+		for (k = start[p]; k < start[p + 1]; ++ k) {
+			q = adj[k];
+			if (opticsdat->pt[q].processed == 0)
+				seedlist_update(&seeds, q, weight[k]);
+		}
+	}
+
+	seedlist_free(&seeds);
+	free(start);
+	free(adj);
+	free(weight);
+}
+
+/*____________________________________________________________________________*/
+/** OPTICS ordering from the minimum spanning tree over mutual reachability;
+	sets index, order, CD and RD of all points and fills 'ordered_data' */
+void mst_order(Dat *dat, Par *par, OpticsDat *opticsdat, Pt **ordered_data, Arg *arg)
+{
+	int p, dim, nEdge;
+	float *coord = 0;
+	float *period = 0;
+	MstEdge *edge = safe_malloc(dat->nData * sizeof(MstEdge));
+	KdTree tree;
+	Mst mst;
+
+	if (par->minPts < 1) {
+		fprintf(stderr, "Spanning tree ordering requires minpts >= 1\n");
+		exit(1);
+	}
+
+	mst.dat = dat;
+	mst.par = par;
+	mst.arg = arg;
+	mst.coreDist = safe_malloc(dat->nData * sizeof(float));
+	mst.comp = safe_malloc(dat->nData * sizeof(int));
+	mst.compBound = safe_malloc(dat->nData * sizeof(float));
+	mst.tree = 0;
+	mst.nodeComp = 0;
+
+	/* k-d tree over point coordinates where available */
+	if ((coord = neighbour_coords(dat, &dim, &period)) != 0) {
+		kdtree_build(&tree, coord, period, dat->nData, dim);
+		mst.tree = &tree;
+		mst.nodeComp = safe_malloc(tree.nNode * sizeof(int));
+	}
+
+	core_distances(&mst, 0);
+	for (p = 0; p < dat->nData; ++ p)
+		opticsdat->pt[p].coreDist = mst.coreDist[p];
+
+	nEdge = boruvka(&mst, edge);
+	traverse(par, opticsdat, ordered_data, edge, nEdge);
+
+	if (mst.tree != 0) {
+		kdtree_free(&tree);
+		free(mst.nodeComp);
+	}
+	free(mst.coreDist);
+	free(mst.comp);
+	free(mst.compBound);
+	free(edge);
+}
+
+/*____________________________________________________________________________*/
+/** core distances over all data points for the local and global orderings,
+	computed in parallel and pruned by a k-d tree where available;
+	'core' flags the points with a defined core distance */
+void mst_core_distances(Dat *dat, Par *par, float *coreDist, char *core, Arg *arg)
+{
+	int dim;
+	float *coord = 0;
+	float *period = 0;
+	KdTree tree;
+	Mst mst;
+
+	if (par->minPts < 1) {
+		fprintf(stderr, "Core distances over all points require minpts >= 1\n");
+		exit(1);
+	}
+
+	mst.dat = dat;
+	mst.par = par;
+	mst.arg = arg;
+	mst.coreDist = coreDist;
+	mst.comp = 0;
+	mst.compBound = 0;
+	mst.tree = 0;
+	mst.nodeComp = 0;
+
+	if ((coord = neighbour_coords(dat, &dim, &period)) != 0) {
+		kdtree_build(&tree, coord, period, dat->nData, dim);
+		mst.tree = &tree;
+	}
+
+	core_distances(&mst, core);
+
+	if (mst.tree != 0)
+		kdtree_free(&tree);
+}
@@ -0,0 +1,34 @@
+/*==============================================================================
+mst.h : OPTICS ordering from a minimum spanning tree over mutual reachability
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef MST_H
+#define MST_H
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "kdtree.h"
+#include "neighbour.h"
+#include "optics.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* spanning tree edge */
+typedef struct {
+	float w; /* mutual reachability distance */
+	int a; /* lower point index */
+	int b; /* higher point index */
+} MstEdge;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void mst_order(Dat *dat, Par *par, OpticsDat *opticsdat, Pt **ordered_data, Arg *arg);
+void mst_core_distances(Dat *dat, Par *par, float *coreDist, char *core, Arg *arg);
+
+#endif
+
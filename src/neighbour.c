@@ -0,0 +1,505 @@
+/*==============================================================================
+neighbour.c : neighbour search engines for epsilon-neighbourhood queries
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#include "neighbour.h"
+
+/* Search engines return a superset of the epsilon neighbours of a point,
+	in increasing index order. The caller verifies every candidate with
+	calc_dist(), therefore neighbour lists are identical to the brute-force
+	scan. Spatial indices enlarge the search radius by a relative SLACK
+	to absorb rounding differences with respect to calc_dist(). */
+#define SLACK 1.0e-5
+
+extern int silent;
+
+/*____________________________________________________________________________*/
+/** candidate index a before b */
+__inline__ static int before_index(int a, int b)
+{
+	return (a < b);
+}
+
+/* sort candidate indices */
+MERGESORT_DEFINE(sort_index, int, before_index)
+
+#ifdef DATAXYZ
+/*____________________________________________________________________________*/
+/** copy xyz coordinates into a contiguous array; all axes are linear */
+float *neighbour_coords(Dat *dat, int *dim, float **period)
+{
+	int i;
+	float *coord = safe_malloc(dat->nData * 3 * sizeof(float));
+
+	for (i = 0; i < dat->nData; ++ i) {
+		coord[i * 3] = dat->x[i];
+		coord[i * 3 + 1] = dat->y[i];
+		coord[i * 3 + 2] = dat->z[i];
+	}
+	*dim = 3;
+	*period = 0;
+
+	return coord;
+}
+#endif
+
+#ifdef DATAANG
+/*____________________________________________________________________________*/
+/** copy angle coordinates into a contiguous array;
+	the torsion angle theta is periodic, as in calc_dist() */
+/* calc_dist() wraps theta differences beyond 180 degrees, which yields
+	at least the wrapped (torus) distance as long as all theta values lie
+	within one period; otherwise no index is built (return 0) */
+float *neighbour_coords(Dat *dat, int *dim, float **period)
+{
+	int i;
+	float *coord = 0;
+	float thetaMin = dat->data[0].theta;
+	float thetaMax = dat->data[0].theta;
+
+	for (i = 1; i < dat->nData; ++ i) {
+		thetaMin = (dat->data[i].theta < thetaMin) ? dat->data[i].theta : thetaMin;
+		thetaMax = (dat->data[i].theta > thetaMax) ? dat->data[i].theta : thetaMax;
+	}
+	if (((double)thetaMax - thetaMin) > 360.)
+		return 0;
+
+	coord = safe_malloc(dat->nData * 3 * sizeof(float));
+	for (i = 0; i < dat->nData; ++ i) {
+		coord[i * 3] = dat->data[i].phi1;
+		coord[i * 3 + 1] = dat->data[i].phi2;
+		coord[i * 3 + 2] = dat->data[i].theta;
+	}
+	*dim = 3;
+	*period = safe_malloc(3 * sizeof(float));
+	(*period)[0] = 0.;
+	(*period)[1] = 0.;
+	(*period)[2] = 360.;
+
+	return coord;
+}
+#endif
+
+#if ! defined DATAXYZ && ! defined DATAANG
+/*____________________________________________________________________________*/
+/** no point coordinates for spatial indices (return 0) */
+float *neighbour_coords(Dat *dat, int *dim, float **period)
+{
+	return 0;
+}
+#endif
+
+#ifdef DATASTR
+/*____________________________________________________________________________*/
+/** build multi-index hash over strings; the number of segments exceeds
+	the largest distance within epsilon, which is an integer window count;
+	returns 0 if no index is built */
+static int build_mih(Mih *mih, Dat *dat, Par *par, Arg *arg)
+{
+	int i, nSeg;
+	int len = strlen(dat->data[0].string);
+	char **str = safe_malloc(dat->nData * sizeof(char *));
+
+	for (i = 0; i < dat->nData; ++ i) {
+		if (strlen(dat->data[i].string) != len) {
+			fprintf(stderr, "Strings differ in length: using brute-force neighbour search\n");
+			free(str);
+			return 0;
+		}
+		str[i] = dat->data[i].string;
+	}
+
+	/* with at least as many mismatches allowed as windows exist,
+		every pair of strings is within epsilon */
+	if (par->eps >= len - arg->w + 1) {
+		if (! silent)
+			fprintf(stderr, "Epsilon covers all windows: using brute-force neighbour search\n");
+		free(str);
+		return 0;
+	}
+	nSeg = (par->eps < 0.) ? 1 : (int)floor(par->eps) + 1;
+
+	mih_build(mih, str, dat->nData, len, arg->w, nSeg);
+	free(str);
+
+	return 1;
+}
+#endif
+
+/*____________________________________________________________________________*/
+/** order neighbours by distance, then by index */
+__inline__ static int before_neighbour(Epsn *a, Epsn *b)
+{
+	return ((a->dist < b->dist) || ((a->dist == b->dist) && (a->index < b->index)));
+}
+
+/*____________________________________________________________________________*/
+/** keep the 'size' nearest neighbours in a max-heap of 'nHeap' entries;
+	the heap top is the most distant one in (distance, index) order */
+void neighbour_heap_push(Epsn *heap, int *nHeap, int size, Epsn neigh)
+{
+	int k, c;
+	Epsn tmp;
+
+	if (*nHeap < size) {
+		/* insert and sift up */
+		heap[k = (*nHeap) ++] = neigh;
+		while ((k > 0) && before_neighbour(&(heap[c = (k - 1) / 2]), &(heap[k]))) {
+			tmp = heap[k];
+			heap[k] = heap[c];
+			heap[c] = tmp;
+			k = c;
+		}
+	} else if ((size > 0) && before_neighbour(&neigh, &(heap[0]))) {
+		/* replace top and sift down */
+		heap[k = 0] = neigh;
+		while ((c = 2 * k + 1) < *nHeap) {
+			if ((c + 1 < *nHeap) && before_neighbour(&(heap[c]), &(heap[c + 1])))
+				++ c;
+			if (! before_neighbour(&(heap[k]), &(heap[c])))
+				break;
+			tmp = heap[k];
+			heap[k] = heap[c];
+			heap[c] = tmp;
+			k = c;
+		}
+	}
+}
+
+/*____________________________________________________________________________*/
+/** set up the neighbour search engine selected by '--index' */
+void neighbour_init(NbIndex *nbindex, Dat *dat, Par *par, Arg *arg)
+{
+#if defined DATAXYZ || defined DATAANG
+	int dim;
+	float *coord;
+	float *period;
+#endif
+
+	nbindex->type = arg->nbIndex;
+	nbindex->nPt = dat->nData;
+	nbindex->allocated = 64;
+	nbindex->cand = 0;
+	nbindex->nEval = 0;
+	nbindex->nEvalBrute = 0;
+	nbindex->nRemoved = 0;
+	nbindex->list = 0;
+	nbindex->nList = 0;
+	nbindex->slice = 0;
+
+	if (nbindex->type == INDEX_BRUTE)
+		return;
+
+	/* without finite epsilon every point is a neighbour */
+	if (par->eps == FLT_MAX) {
+		if (! silent)
+			fprintf(stderr, "Infinite epsilon: using brute-force neighbour search\n");
+		nbindex->type = INDEX_BRUTE;
+		return;
+	}
+
+	switch (nbindex->type) {
+		case INDEX_KDTREE:
+		case INDEX_GRID:
+#if defined DATAXYZ || defined DATAANG
+			if ((coord = neighbour_coords(dat, &dim, &period)) == 0) {
+				fprintf(stderr, "Angles span more than one period: using brute-force neighbour search\n");
+				nbindex->type = INDEX_BRUTE;
+				return;
+			}
+			if (nbindex->type == INDEX_KDTREE)
+				kdtree_build(&(nbindex->kdtree), coord, period, dat->nData, dim);
+			else
+				grid_build(&(nbindex->grid), coord, period, dat->nData, dim, par->eps * (1. + SLACK));
+			break;
+#else
+			fprintf(stderr, "Spatial index requires xyz or angle coordinates: using brute-force neighbour search\n");
+			nbindex->type = INDEX_BRUTE;
+			return;
+#endif
+		case INDEX_VPTREE:
+			/* pruning by the triangle inequality is exact for metrics only */
+			if (! metric_dist()) {
+				fprintf(stderr, "Distance is not a metric: using brute-force neighbour search\n");
+				nbindex->type = INDEX_BRUTE;
+				return;
+			}
+			vptree_build(&(nbindex->vptree), dat, arg);
+			break;
+		case INDEX_PIVOT:
+			if (! metric_dist()) {
+				fprintf(stderr, "Distance is not a metric: using brute-force neighbour search\n");
+				nbindex->type = INDEX_BRUTE;
+				return;
+			}
+			pivot_build(&(nbindex->pivot), dat, arg->nPivot, arg);
+			break;
+		case INDEX_MIH:
+#ifdef DATASTR
+			if (! build_mih(&(nbindex->mih), dat, par, arg)) {
+				nbindex->type = INDEX_BRUTE;
+				return;
+			}
+			break;
+#else
+			fprintf(stderr, "Multi-index hashing requires strings: using brute-force neighbour search\n");
+			nbindex->type = INDEX_BRUTE;
+			return;
+#endif
+	}
+
+	nbindex->cand = safe_malloc(nbindex->allocated * sizeof(int));
+}
+
+/*____________________________________________________________________________*/
+/** candidate neighbours of point i: returns the number of candidates,
+	which are stored in increasing index order in nbindex->cand;
+	for brute-force search all points are candidates and cand is not set */
+int neighbour_candidates(NbIndex *nbindex, Dat *dat, Par *par, int i, Arg *arg)
+{
+	int nCand = 0;
+	float radius = par->eps * (1. + SLACK);
+
+	/* the brute-force scan evaluates all unprocessed points */
+	nbindex->nEvalBrute += dat->nData - nbindex->nRemoved;
+
+	switch (nbindex->type) {
+		case INDEX_BRUTE:
+			nbindex->nEval += dat->nData - nbindex->nRemoved;
+			return dat->nData;
+		case INDEX_KDTREE:
+			nCand = kdtree_range(&(nbindex->kdtree),
+						&(nbindex->kdtree.coord[i * nbindex->kdtree.dim]), radius,
+						&(nbindex->cand), &(nbindex->allocated));
+			break;
+		case INDEX_GRID:
+			nCand = grid_range(&(nbindex->grid),
+						&(nbindex->grid.coord[i * nbindex->grid.dim]), radius,
+						&(nbindex->cand), &(nbindex->allocated));
+			break;
+		case INDEX_VPTREE:
+			nCand = vptree_range(&(nbindex->vptree), dat, i, radius, arg,
+						&(nbindex->cand), &(nbindex->allocated));
+			break;
+		case INDEX_MIH:
+			nCand = mih_range(&(nbindex->mih), i, &(nbindex->cand), &(nbindex->allocated));
+			break;
+		case INDEX_PIVOT:
+			nCand = pivot_range(&(nbindex->pivot), i, radius, &(nbindex->cand), &(nbindex->allocated));
+			break;
+		case INDEX_CACHE:
+			if (nbindex->nList[i] >= nbindex->allocated) {
+				nbindex->allocated = nbindex->nList[i] + 1;
+				nbindex->cand = safe_realloc(nbindex->cand, nbindex->allocated * sizeof(int));
+			}
+			for (nCand = 0; nCand < nbindex->nList[i]; ++ nCand)
+				nbindex->cand[nCand] = nbindex->list[i][nCand].index;
+			break;
+	}
+
+	/* all candidates are verified by the caller */
+	nbindex->nEval += nCand;
+
+	/* restore input order of candidates; pivot and cached candidates are in order */
+	if ((nCand > 1) && (nbindex->type != INDEX_PIVOT) && (nbindex->type != INDEX_CACHE))
+		sort_index(nbindex->cand, nCand);
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** candidate neighbours of a point outside the data set, given by its
+	coordinates 'query'; as neighbour_candidates() for the brute-force
+	scan and the spatial indices (k-d tree, grid) */
+int neighbour_candidates_at(NbIndex *nbindex, Dat *dat, Par *par, float *query)
+{
+	int nCand = 0;
+	float radius = par->eps * (1. + SLACK);
+
+	nbindex->nEvalBrute += dat->nData - nbindex->nRemoved;
+
+	switch (nbindex->type) {
+		case INDEX_BRUTE:
+			nbindex->nEval += dat->nData - nbindex->nRemoved;
+			return dat->nData;
+		case INDEX_KDTREE:
+			nCand = kdtree_range(&(nbindex->kdtree), query, radius,
+						&(nbindex->cand), &(nbindex->allocated));
+			break;
+		case INDEX_GRID:
+			nCand = grid_range(&(nbindex->grid), query, radius,
+						&(nbindex->cand), &(nbindex->allocated));
+			break;
+		default:
+			fprintf(stderr, "Error: search engine %d needs the query point in the index\n", nbindex->type);
+			exit(1);
+	}
+
+	nbindex->nEval += nCand;
+
+	if (nCand > 1)
+		sort_index(nbindex->cand, nCand);
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** remove processed point i from the search index */
+void neighbour_remove(NbIndex *nbindex, int i)
+{
+	++ nbindex->nRemoved;
+
+	switch (nbindex->type) {
+		case INDEX_KDTREE:
+			kdtree_remove(&(nbindex->kdtree), i);
+			break;
+		case INDEX_GRID:
+			grid_remove(&(nbindex->grid), i);
+			break;
+		case INDEX_VPTREE:
+			vptree_remove(&(nbindex->vptree), i);
+			break;
+		case INDEX_MIH:
+			mih_remove(&(nbindex->mih), i);
+			break;
+		case INDEX_PIVOT:
+			pivot_remove(&(nbindex->pivot), i);
+			break;
+	}
+}
+
+/*____________________________________________________________________________*/
+/** report distance evaluations of neighbour searches */
+void neighbour_report(NbIndex *nbindex)
+{
+	long long nEval = nbindex->nEval;
+
+	if (nbindex->type == INDEX_VPTREE)
+		nEval += nbindex->vptree.nEval;
+	if (nbindex->type == INDEX_PIVOT)
+		nEval += nbindex->pivot.nEval;
+
+	if (silent)
+		return;
+
+	if (nbindex->nEvalBrute > 0)
+		fprintf(stderr, "%lld distance evaluations in neighbour search (%.1f%% of brute force)\n",
+			nEval, 100. * nEval / nbindex->nEvalBrute);
+	if ((nbindex->type == INDEX_PIVOT) && (nbindex->pivot.nTested > 0))
+		fprintf(stderr, "%d pivots pruned %lld of %lld point pairs (%.1f%%)\n",
+			nbindex->pivot.nPivot, nbindex->pivot.nPruned, nbindex->pivot.nTested,
+			100. * nbindex->pivot.nPruned / nbindex->pivot.nTested);
+}
+
+/*____________________________________________________________________________*/
+/** free memory of the search engine */
+static void free_engine(NbIndex *nbindex)
+{
+	switch (nbindex->type) {
+		case INDEX_KDTREE:
+			kdtree_free(&(nbindex->kdtree));
+			break;
+		case INDEX_GRID:
+			grid_free(&(nbindex->grid));
+			break;
+		case INDEX_VPTREE:
+			vptree_free(&(nbindex->vptree));
+			break;
+		case INDEX_MIH:
+			mih_free(&(nbindex->mih));
+			break;
+		case INDEX_PIVOT:
+			pivot_free(&(nbindex->pivot));
+			break;
+	}
+}
+
+/*____________________________________________________________________________*/
+/** free search index memory */
+void neighbour_free(NbIndex *nbindex)
+{
+	int i;
+
+	free_engine(nbindex);
+
+	if (nbindex->type == INDEX_CACHE) {
+		for (i = 0; i < nbindex->nPt; ++ i)
+			free(nbindex->list[i]);
+		free(nbindex->list);
+		free(nbindex->nList);
+	}
+
+	free(nbindex->cand);
+}
+
+/*____________________________________________________________________________*/
+/** append neighbour j at distance 'dist' to the cached list of point i */
+__inline__ static void cache_append(NbIndex *nbindex, int *allocated, int i, int j, float dist)
+{
+	nbindex->list[i][nbindex->nList[i]].index = j;
+	nbindex->list[i][nbindex->nList[i] ++].dist = dist;
+	/* allocate more space to neighbour array if needed */
+	if (nbindex->nList[i] == allocated[i]) {
+		allocated[i] += 64;
+		nbindex->list[i] = safe_realloc(nbindex->list[i], allocated[i] * sizeof(Epsn));
+	}
+}
+
+/*____________________________________________________________________________*/
+/** replace the search index by the epsilon neighbourhoods of all points,
+	for several orderings of the same data; neighbour lists are in
+	increasing index order with distances calc_dist(i, j) as in
+	the epsilon neighbourhood of point i during ordering */
+/* Metric distances are symmetric: each pair is evaluated once, by the
+	query of its lower index; candidates include all epsilon neighbours. */
+void neighbour_cache(NbIndex *nbindex, Dat *dat, Par *par, Arg *arg)
+{
+	int c, i, j, nCand;
+	int symmetric = metric_dist();
+	int *allocated = safe_malloc(dat->nData * sizeof(int));
+	long long nNeigh = 0;
+	float dist;
+
+	nbindex->list = safe_malloc(dat->nData * sizeof(Epsn *));
+	nbindex->nList = safe_malloc(dat->nData * sizeof(int));
+	for (i = 0; i < dat->nData; ++ i) {
+		allocated[i] = 64;
+		nbindex->list[i] = safe_malloc(allocated[i] * sizeof(Epsn));
+		nbindex->nList[i] = 0;
+	}
+
+	for (i = 0; i < dat->nData; ++ i) {
+		nCand = neighbour_candidates(nbindex, dat, par, i, arg);
+
+		for (c = 0; c < nCand; ++ c) {
+			j = (nbindex->type == INDEX_BRUTE) ? c : nbindex->cand[c];
+			if ((j == i) || (symmetric && (j < i)))
+				continue;
+			if ((dist = calc_dist(dat, i, j, arg)) > par->eps)
+				continue;
+			cache_append(nbindex, allocated, i, j, dist);
+			/* lower indices of list j precede j and its own neighbours */
+			if (symmetric)
+				cache_append(nbindex, allocated, j, i, dist);
+		}
+
+		nNeigh += nbindex->nList[i];
+	}
+
+	neighbour_report(nbindex);
+	if (! silent)
+		fprintf(stderr, "%lld neighbours within %5.2e cached\n", nNeigh, par->eps);
+
+	/* the lists replace the search engine */
+	free_engine(nbindex);
+	nbindex->type = INDEX_CACHE;
+	if (nbindex->cand == 0)
+		nbindex->cand = safe_malloc(nbindex->allocated * sizeof(int));
+	nbindex->nEval = 0;
+	nbindex->nEvalBrute = 0;
+	nbindex->nRemoved = 0;
+
+	free(allocated);
+}
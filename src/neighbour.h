@@ -0,0 +1,54 @@
+/*==============================================================================
+neighbour.h : neighbour search engines for epsilon-neighbourhood queries
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef NEIGHBOUR_H
+#define NEIGHBOUR_H
+
+#include "grid.h"
+#include "kdtree.h"
+#include "mih.h"
+#include "optics.h"
+#include "pivot.h"
+#include "vptree.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* data points distributed over MPI ranks, see slice.h */
+typedef struct Slice Slice;
+
+/* neighbour search index */
+typedef struct {
+	int type; /* search engine, see arg.h */
+	int nPt; /* number of data points */
+	int *cand; /* candidate neighbours of the current query point */
+	int allocated; /* allocated size of candidate array */
+	KdTree kdtree; /* k-d tree over point coordinates */
+	Grid grid; /* uniform grid over point coordinates */
+	VpTree vptree; /* vantage-point tree over calc_dist() */
+	Mih mih; /* multi-index hash over string segments */
+	PivotTable pivot; /* distances to pivot points */
+	Epsn **list; /* cached epsilon neighbourhood of each point */
+	int *nList; /* number of cached neighbours of each point */
+	Slice *slice; /* distributed data points (INDEX_SLICE), otherwise 0 */
+	long long nEval; /* distance evaluations of candidate verification */
+	long long nEvalBrute; /* distance evaluations of a brute-force scan */
+	int nRemoved; /* number of points removed from search */
+} NbIndex;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+float *neighbour_coords(Dat *dat, int *dim, float **period);
+void neighbour_heap_push(Epsn *heap, int *nHeap, int size, Epsn neigh);
+void neighbour_init(NbIndex *nbindex, Dat *dat, Par *par, Arg *arg);
+int neighbour_candidates(NbIndex *nbindex, Dat *dat, Par *par, int i, Arg *arg);
+int neighbour_candidates_at(NbIndex *nbindex, Dat *dat, Par *par, float *query);
+void neighbour_cache(NbIndex *nbindex, Dat *dat, Par *par, Arg *arg);
+void neighbour_remove(NbIndex *nbindex, int i);
+void neighbour_report(NbIndex *nbindex);
+void neighbour_free(NbIndex *nbindex);
+
+#endif
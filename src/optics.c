@@ -11,11 +11,22 @@ Read the COPYING file for license information.
 =============================================================================*/
 
 #include "optics.h"
+#include "mst.h"
+#include "neighbour.h"
+#include "prefetch.h"
+#include "rmq.h"
+#include "slice.h"
+#include "state.h"
+#include "stream.h"
+#include "xi.h"
 
 /*_____________________________________________________________________________*/
 /** global parameters */
 int silent = 0;
 
+/* minimal number of candidate neighbours for a scan on several threads */
+#define PARALLEL_MIN_CAND 4096
+
 /*____________________________________________________________________________*/
 /** min floats */
 __inline__ static float min_float(float a, float b)
@@ -31,24 +42,30 @@ __inline__ static float max_float(float a, float b)
 }
 
 /*____________________________________________________________________________*/
-/** compare distances */
-__inline__ static int compare_distances(Epsn *a, Epsn *b)
+/** order neighbours by distance, then by index */
+__inline__ static int before_neighbour(Epsn *a, Epsn *b)
 {
-	float arg_a = (float) a->dist;
-	float arg_b = (float) b->dist;
-
-	return ((arg_a < arg_b ) ? -1 : (arg_a > arg_b) ? 1 : 0);
+	return ((a->dist < b->dist) || ((a->dist == b->dist) && (a->index < b->index)));
 }
 
 /*____________________________________________________________________________*/
-/** compare RD by dereferencing */
-__inline__ static int compare_RD_deref(Pt **a, Pt **b)
+/** point a before b in RD order by dereferencing */
+__inline__ static int before_RD_deref(Pt *a, Pt *b)
 {
-	float arg_a = (float) (**a).reachDist;
-	float arg_b = (float) (**b).reachDist;
-
     /* WARNING: decreasing */
-	return ((arg_a < arg_b ) ? 1 : (arg_a > arg_b) ? -1 : 0);
+	return ((*a).reachDist > (*b).reachDist);
+}
+
+/* sort points by RD */
+MERGESORT_DEFINE(sort_RD, Pt *, before_RD_deref)
+
+/*____________________________________________________________________________*/
+/** point i is a core point: by its CD over all points if precomputed,
+	otherwise by its number of unprocessed epsilon neighbours */
+__inline__ static int is_core(Par *par, OpticsDat *opticsdat, int i)
+{
+	return ((opticsdat->core != 0) ? opticsdat->core[i] :
+				(opticsdat->pt[i].nEpsNeigh >= par->minPts));
 }
 
 /*____________________________________________________________________________*/
@@ -57,6 +74,9 @@ static int initialise(OpticsDat *opticsdat, Par *par)
 {
 	unsigned int i;
 
+	opticsdat->firstUnprocessed = 0;
+	opticsdat->core = 0;
+
 	for (i = 0; i < opticsdat->nPt; ++ i) {
 		/* optics data point */
 		opticsdat->pt[i].processed = 0;
@@ -87,21 +107,161 @@ static int reset_processed_flag(Pt **pointer_to_data, int npoints)
 	return 0;
 }
 
+#ifdef DATAXYZ
+/*____________________________________________________________________________*/
+/* brute-force scan of the points [first, last) for epsilon neighbours of
+	point i, appended to 'neigh' ('n' entries of 'allocated'): distances to
+	XYZ_BLOCK points at a time, and only the points within epsilon are
+	checked for being processed; returns the first point not scanned */
+static unsigned int scan_blocks(Dat *dat, Par *par, OpticsDat *opticsdat, int i, unsigned int first, unsigned int last, Epsn **neigh, int *n, unsigned int *allocated)
+{
+	unsigned int c, j, k, mask;
+	float dist[XYZ_BLOCK];
+
+	for (c = first; c + XYZ_BLOCK <= last; c += XYZ_BLOCK) {
+		mask = calc_dist_block(dat, i, c, par->eps, dist);
+		for (k = 0; mask != 0; ++ k, mask >>= 1) {
+			j = c + k;
+			if (((mask & 1) == 0) || (j == i) || (opticsdat->pt[j].processed > 0)) continue;
+
+			(*neigh)[*n].index = j;
+			(*neigh)[*n].dist = dist[k];
+			/* allocate more space to neighbour array if needed */
+			if (++ (*n) == *allocated) {
+				*allocated += 64;
+				*neigh = safe_realloc(*neigh, *allocated * sizeof(Epsn));
+			}
+		}
+	}
+
+	return c;
+}
+#endif
+
+#ifdef _OPENMP
+/*____________________________________________________________________________*/
+/* epsilon-neighbourhood of point i among 'nCand' candidates on several threads:
+	each thread scans a contiguous block of candidates into its own buffer,
+	and the buffers are appended in thread order, which is the candidate
+	order of the serial loop; the neighbour list is therefore identical */
+static void parallel_neighbourhood(Dat *dat, Par *par, OpticsDat *opticsdat, int i, NbIndex *nbindex, unsigned int nCand, Arg *arg)
+{
+	int t; /* thread index */
+	int nThread = omp_get_max_threads();
+	Epsn **buffer = safe_malloc(nThread * sizeof(Epsn *)); /* neighbours per thread */
+	int *nBuffer = safe_malloc(nThread * sizeof(int)); /* number of neighbours per thread */
+	int nEpsNeigh = 0;
+
+	for (t = 0; t < nThread; ++ t) {
+		buffer[t] = 0;
+		nBuffer[t] = 0;
+	}
+
+	#pragma omp parallel num_threads(nThread)
+	{
+		int tid = omp_get_thread_num();
+		int nt = omp_get_num_threads();
+		unsigned int c, j;
+		unsigned int first = (unsigned int)(((long long)nCand * tid) / nt);
+		unsigned int last = (unsigned int)(((long long)nCand * (tid + 1)) / nt);
+		unsigned int allocated = 64;
+		float dist;
+
+		buffer[tid] = safe_malloc(allocated * sizeof(Epsn));
+
+		c = first;
+#ifdef DATAXYZ
+		/* brute force: distances by blocks of points */
+		if (nbindex->type == INDEX_BRUTE)
+			c = scan_blocks(dat, par, opticsdat, i, first, last, &(buffer[tid]), &(nBuffer[tid]), &allocated);
+#endif
+		for (; c < last; ++ c) {
+			j = (nbindex->type == INDEX_BRUTE) ? c : nbindex->cand[c];
+			if ((j == i) || (opticsdat->pt[j].processed > 0)) continue;
+
+			if ((dist = calc_dist(dat, i, j, arg)) <= par->eps) {
+				buffer[tid][nBuffer[tid]].index = j;
+				buffer[tid][nBuffer[tid]].dist = dist;
+				/* allocate more space to the thread buffer if needed */
+				if (++ nBuffer[tid] == allocated) {
+					allocated += 64;
+					buffer[tid] = safe_realloc(buffer[tid], allocated * sizeof(Epsn));
+				}
+			}
+		}
+	}
+
+	/* append the thread buffers in thread order */
+	for (t = 0; t < nThread; ++ t)
+		nEpsNeigh += nBuffer[t];
+	opticsdat->pt[i].epsNeigh = safe_realloc(opticsdat->pt[i].epsNeigh, (nEpsNeigh + 64) * sizeof(Epsn));
+	for (t = 0; t < nThread; ++ t) {
+		if (nBuffer[t] > 0)
+			memcpy(&(opticsdat->pt[i].epsNeigh[opticsdat->pt[i].nEpsNeigh]), buffer[t], nBuffer[t] * sizeof(Epsn));
+		opticsdat->pt[i].nEpsNeigh += nBuffer[t];
+		free(buffer[t]);
+	}
+
+	free(buffer);
+	free(nBuffer);
+}
+#endif
+
 /*____________________________________________________________________________*/
 /* epsilon-neighbourhood */
 /* This defines the neighbourhood of point i: the number of neighbouring
  *	points within the boundary epsilon, a list of their 'index' and their 
  *	distance 'dist'. */
-static void epsilon_neighbourhood(Dat *dat, Par *par, OpticsDat *opticsdat, int i, Arg *arg)
+static void epsilon_neighbourhood(Dat *dat, Par *par, OpticsDat *opticsdat, int i, NbIndex *nbindex, Arg *arg)
 {
-	unsigned int j;
+	unsigned int c, j;
+	unsigned int nCand;
 	unsigned int allocated = 64;
 	float dist = 0;
 
 	/* allocate space to record neighbours */
 	opticsdat->pt[i].epsNeigh = safe_malloc(allocated * sizeof(Epsn));
 
-	for (j = 0, opticsdat->pt[i].nEpsNeigh = 0; j < dat->nData; ++ j) {
+	/* cached neighbourhood: copy the unprocessed neighbours */
+	if (nbindex->type == INDEX_CACHE) {
+		for (c = 0, opticsdat->pt[i].nEpsNeigh = 0; c < nbindex->nList[i]; ++ c) {
+			if (opticsdat->pt[nbindex->list[i][c].index].processed > 0) continue;
+			opticsdat->pt[i].epsNeigh[opticsdat->pt[i].nEpsNeigh ++] = nbindex->list[i][c];
+			/* allocate more space to neighbour array if needed */
+			if (opticsdat->pt[i].nEpsNeigh == allocated) {
+				allocated += 64;
+				opticsdat->pt[i].epsNeigh = safe_realloc(opticsdat->pt[i].epsNeigh, allocated * sizeof(Epsn));
+			}
+		}
+		nCand = 0;
+#if defined MPI && defined DATAXYZ
+	} else if (nbindex->type == INDEX_SLICE) {
+		/* distributed data: all ranks search their points */
+		slice_neighbourhood(nbindex->slice, par, opticsdat, dat, i, arg);
+		nCand = 0;
+#endif
+	} else {
+		/* candidate neighbours: all points or those returned by the search index */
+		nCand = neighbour_candidates(nbindex, dat, par, i, arg);
+		opticsdat->pt[i].nEpsNeigh = 0;
+	}
+
+#ifdef _OPENMP
+	/* many candidates: scan on several threads */
+	if ((nCand >= PARALLEL_MIN_CAND) && (omp_get_max_threads() > 1)) {
+		parallel_neighbourhood(dat, par, opticsdat, i, nbindex, nCand, arg);
+		nCand = 0;
+	}
+#endif
+
+	c = 0;
+#ifdef DATAXYZ
+	/* brute force: distances by blocks of points */
+	if (nbindex->type == INDEX_BRUTE)
+		c = scan_blocks(dat, par, opticsdat, i, 0, nCand, &(opticsdat->pt[i].epsNeigh), &(opticsdat->pt[i].nEpsNeigh), &allocated);
+#endif
+	for (; c < nCand; ++ c) {
+		j = (nbindex->type == INDEX_BRUTE) ? c : nbindex->cand[c];
 		if ((j == i) || (opticsdat->pt[j].processed > 0)) continue;
 
 		/* record all points in epsilon neighbourhood */
@@ -126,6 +286,63 @@ static void epsilon_neighbourhood(Dat *dat, Par *par, OpticsDat *opticsdat, int
             i, opticsdat->pt[i].nEpsNeigh, par->eps);
 }
 
+/*____________________________________________________________________________*/
+/** swap two neighbours */
+__inline__ static void swap_neighbour(Epsn *a, Epsn *b)
+{
+	Epsn tmp = *a;
+
+	*a = *b;
+	*b = tmp;
+}
+
+/*____________________________________________________________________________*/
+/* partial sort of neighbours (quickselect): afterwards neighbour k is the
+	k-th neighbour in (distance, index) order, preceded by closer and
+	followed by more distant neighbours */
+/* Neighbour lists are in increasing index order, so this is the neighbour
+	at position k after a stable sort by distance. Indices are unique,
+	therefore all neighbours are distinct in this order. */
+static void select_neighbour(Epsn *neigh, int n, int k)
+{
+	int l = 0;
+	int r = n - 1;
+	int m, i, j;
+	Epsn pivot;
+
+	while (r > l) {
+		/* median of three as pivot, moved to position l */
+		m = l + (r - l) / 2;
+		if (before_neighbour(&(neigh[m]), &(neigh[l])))
+			swap_neighbour(&(neigh[m]), &(neigh[l]));
+		if (before_neighbour(&(neigh[r]), &(neigh[l])))
+			swap_neighbour(&(neigh[r]), &(neigh[l]));
+		if (before_neighbour(&(neigh[r]), &(neigh[m])))
+			swap_neighbour(&(neigh[r]), &(neigh[m]));
+		swap_neighbour(&(neigh[m]), &(neigh[l]));
+		pivot = neigh[l];
+
+		/* partition (l,r] around the pivot */
+		for (i = l + 1, j = r; ; ) {
+			while ((i <= r) && before_neighbour(&(neigh[i]), &pivot))
+				++ i;
+			while (before_neighbour(&pivot, &(neigh[j])))
+				-- j;
+			if (i >= j)
+				break;
+			swap_neighbour(&(neigh[i ++]), &(neigh[j --]));
+		}
+		swap_neighbour(&(neigh[l]), &(neigh[j]));
+
+		if (j == k)
+			return;
+		else if (k < j)
+			r = j - 1;
+		else
+			l = j + 1;
+	}
+}
+
 /*____________________________________________________________________________*/
 /* define core-distance of point i and reachability distance to all 
 	epsilon neighbours j; update reachability-distance of point j 
@@ -133,31 +350,40 @@ static void epsilon_neighbourhood(Dat *dat, Par *par, OpticsDat *opticsdat, int
 static int cd_rd(Par *par, OpticsDat *opticsdat, int i)
 {
 	unsigned int j, k = 0;
-	int (*fcmp)() = &compare_distances;
 	float rd;
     /* minimum reachability distance(ij) set to eps */
     /* see Daszykowski et al. for details */
 	float rd_min = par->eps; /* lowest RD */
 	int i_rd_min = -1; /* index of neighbour j with lowest RD */
+	int j_rd_min = -1; /* position of neighbour j with lowest RD in list */
 	int next = -1; /* next point: the one among j with minimum RD to point i */
 
 	/* Definition 5 of Ref. 1.: 
 		core-distance(i) = distance(i,j=MinPts) */
 	/* if point i has enough neighbours */
-	if (opticsdat->pt[i].nEpsNeigh >= par->minPts) {
-		/* sort neighbours by neighbour distance */
-		MergeSort((void *)opticsdat->pt[i].epsNeigh, opticsdat->pt[i].nEpsNeigh, sizeof(Epsn), fcmp);
-		/* record neighbour distance of minPts point as core distance */
-		opticsdat->pt[i].coreDist = opticsdat->pt[i].epsNeigh[par->minPts - 1].dist;
+	if (is_core(par, opticsdat, i)) {
+		/* unless precomputed over all points */
+		if (opticsdat->core == 0) {
+			/* select the minPts-th neighbour by neighbour distance */
+			select_neighbour(opticsdat->pt[i].epsNeigh, opticsdat->pt[i].nEpsNeigh, par->minPts - 1);
+			/* record neighbour distance of minPts point as core distance */
+			opticsdat->pt[i].coreDist = opticsdat->pt[i].epsNeigh[par->minPts - 1].dist;
+		}
 		/* Definition 6 of Ref. 2.:
 			reachability-distance(i,j) = max(core-distance(i), distance(ij)) */
 		for (j = 0; j < opticsdat->pt[i].nEpsNeigh; ++ j) {
             k = opticsdat->pt[i].epsNeigh[j].index; /* index of neighbourogh j in ord */
 			rd = max_float(opticsdat->pt[i].coreDist, opticsdat->pt[i].epsNeigh[j].dist);
 			opticsdat->pt[k].reachDist = min_float(rd, opticsdat->pt[k].reachDist); 
-			/* define index of closest neighbour */
-			if ((rd_min = min_float(rd_min, opticsdat->pt[k].reachDist)) == opticsdat->pt[k].reachDist)
+			/* define index of closest neighbour: among equal RDs the
+				last one in (distance, index) order, as for sorted neighbours */
+			if ((opticsdat->pt[k].reachDist < rd_min) ||
+				((opticsdat->pt[k].reachDist == rd_min) && ((i_rd_min < 0) ||
+				! before_neighbour(&(opticsdat->pt[i].epsNeigh[j]), &(opticsdat->pt[i].epsNeigh[j_rd_min]))))) {
+				rd_min = opticsdat->pt[k].reachDist;
 				i_rd_min = k;
+				j_rd_min = j;
+			}
 		}
 		next = i_rd_min;
 	} else {
@@ -177,21 +403,228 @@ static int cd_rd(Par *par, OpticsDat *opticsdat, int i)
 	return next;
 }
 
+/*____________________________________________________________________________*/
+/* distances of point i to the active points [first, last), which are
+	compacted to the unprocessed ones from 'first' on; the epsilon neighbours
+	are counted in 'nEps' and the minPts nearest kept in 'heap';
+	returns the number of unprocessed points */
+static int knn_scan(Dat *dat, Par *par, OpticsDat *opticsdat, int i, Knn *knn, int first, int last, Epsn *heap, int *nHeap, int *nEps, Arg *arg)
+{
+	int c, k, nAct;
+	Epsn neigh;
+
+	/* processed points leave the list */
+	for (c = first, nAct = first; c < last; ++ c) {
+		k = knn->active[c];
+		if (opticsdat->pt[k].processed == 0)
+			knn->active[nAct ++] = k;
+	}
+
+	c = first;
+#ifdef DATAXYZ
+	/* distances by blocks of points */
+	for (; c + XYZ_BLOCK <= nAct; c += XYZ_BLOCK)
+		calc_dist_gather(dat, i, &(knn->active[c]), par->eps, &(knn->dist[c]));
+#endif
+	for (; c < nAct; ++ c)
+		knn->dist[c] = calc_dist(dat, i, knn->active[c], arg);
+
+	for (c = first; c < nAct; ++ c) {
+		if (! (knn->dist[c] <= par->eps)) continue;
+		++ (*nEps);
+
+		/* keep the minPts nearest neighbours */
+		neigh.index = knn->active[c];
+		neigh.dist = knn->dist[c];
+		neighbour_heap_push(heap, nHeap, par->minPts, neigh);
+	}
+
+	return nAct - first;
+}
+
+#ifdef _OPENMP
+/*____________________________________________________________________________*/
+/* knn_scan() on several threads: each thread scans a contiguous block of
+	the active points with its own heap; the compacted blocks are joined and
+	the heaps merged in block order, so the result is that of the serial scan */
+static void parallel_knn_scan(Dat *dat, Par *par, OpticsDat *opticsdat, int i, Knn *knn, int *nHeap, Arg *arg)
+{
+	int t; /* thread index */
+	int c, nAct = 0;
+	int nThread = (omp_get_max_threads() < knn->nThread) ? omp_get_max_threads() : knn->nThread;
+	int *first = safe_malloc(nThread * sizeof(int)); /* first active point per thread */
+	int *nKept = safe_malloc(nThread * sizeof(int)); /* unprocessed points per thread */
+	int *nHeapT = safe_malloc(nThread * sizeof(int)); /* heap size per thread */
+	int *nEps = safe_malloc(nThread * sizeof(int)); /* neighbours per thread */
+
+	for (t = 0; t < nThread; ++ t) {
+		first[t] = 0;
+		nKept[t] = 0;
+		nHeapT[t] = 0;
+		nEps[t] = 0;
+	}
+
+	#pragma omp parallel num_threads(nThread)
+	{
+		int tid = omp_get_thread_num();
+		int nt = omp_get_num_threads();
+		int last = (int)(((long long)knn->nActive * (tid + 1)) / nt);
+
+		first[tid] = (int)(((long long)knn->nActive * tid) / nt);
+		nKept[tid] = knn_scan(dat, par, opticsdat, i, knn, first[tid], last,
+			&(knn->heap[tid * par->minPts]), &(nHeapT[tid]), &(nEps[tid]), arg);
+	}
+
+	/* join the blocks and merge the heaps into the first one */
+	*nHeap = nHeapT[0];
+	for (t = 0; t < nThread; ++ t) {
+		if ((t > 0) && (nKept[t] > 0)) {
+			memmove(&(knn->active[nAct]), &(knn->active[first[t]]), nKept[t] * sizeof(int));
+			memmove(&(knn->dist[nAct]), &(knn->dist[first[t]]), nKept[t] * sizeof(float));
+		}
+		nAct += nKept[t];
+		opticsdat->pt[i].nEpsNeigh += nEps[t];
+		for (c = 0; (t > 0) && (c < nHeapT[t]); ++ c)
+			neighbour_heap_push(knn->heap, nHeap, par->minPts, knn->heap[t * par->minPts + c]);
+	}
+	knn->nActive = nAct;
+
+	free(first);
+	free(nKept);
+	free(nHeapT);
+	free(nEps);
+}
+#endif
+
+/*____________________________________________________________________________*/
+/* bounded alternative to epsilon_neighbourhood() and cd_rd() for infinite
+	epsilon, where all unprocessed points are neighbours: the distances to
+	point i go into a reused buffer, the core distance comes from a max-heap
+	of the minPts nearest neighbours, and no neighbour list is sorted.
+	The result is identical to cd_rd() on the stably sorted list:
+	CD is the distance of the minPts-th neighbour in (distance, index) order
+	and 'next' is the last neighbour in this order with the minimum RD. */
+static int knn_cd_rd(Dat *dat, Par *par, OpticsDat *opticsdat, int i, Knn *knn, Arg *arg)
+{
+	int c, k, nHeap = 0;
+	float rd;
+	float rd_min = par->eps; /* lowest RD */
+	float next_dist = 0.; /* neighbour distance of point 'next' */
+	int next = -1; /* next point: the one among j with minimum RD to point i */
+
+	/* distances to unprocessed points; processed points leave the list */
+	opticsdat->pt[i].nEpsNeigh = 0;
+#ifdef _OPENMP
+	/* many points: scan on several threads */
+	if ((knn->nActive >= PARALLEL_MIN_CAND) && (omp_get_max_threads() > 1) && (knn->nThread > 1))
+		parallel_knn_scan(dat, par, opticsdat, i, knn, &nHeap, arg);
+	else
+#endif
+		knn->nActive = knn_scan(dat, par, opticsdat, i, knn, 0, knn->nActive,
+			knn->heap, &nHeap, &(opticsdat->pt[i].nEpsNeigh), arg);
+
+	if (! silent)
+		fprintf(stderr, "point %d has %d neighbours within %5.2e\n",
+			i, opticsdat->pt[i].nEpsNeigh, par->eps);
+
+	/* not enough neighbours: CD undefined, RDs unchanged */
+	if (! is_core(par, opticsdat, i)) {
+		opticsdat->pt[i].coreDist = par->eps + 1.0;
+		return -1;
+	}
+
+	/* the heap top is the minPts-th neighbour, unless precomputed */
+	if (opticsdat->core == 0)
+		opticsdat->pt[i].coreDist = knn->heap[0].dist;
+
+	for (c = 0; c < knn->nActive; ++ c) {
+		if (! (knn->dist[c] <= par->eps)) continue;
+		k = knn->active[c];
+		rd = max_float(opticsdat->pt[i].coreDist, knn->dist[c]);
+		opticsdat->pt[k].reachDist = min_float(rd, opticsdat->pt[k].reachDist);
+		/* points are visited in increasing index order */
+		if ((opticsdat->pt[k].reachDist < rd_min) ||
+			((opticsdat->pt[k].reachDist == rd_min) && ((next < 0) || (knn->dist[c] >= next_dist)))) {
+			rd_min = opticsdat->pt[k].reachDist;
+			next = k;
+			next_dist = knn->dist[c];
+		}
+	}
+
+	return next;
+}
+
+/*____________________________________________________________________________*/
+/* set up bounded neighbour search if epsilon is infinite,
+	unless the data are distributed */
+static void knn_init(Knn *knn, Par *par, NbIndex *nbindex, int nPt)
+{
+	int i;
+
+	knn->nActive = 0;
+	knn->active = 0;
+	knn->dist = 0;
+	knn->heap = 0;
+	knn->nThread = 1;
+
+	if ((par->eps != FLT_MAX) || (par->minPts < 1) || (nbindex->type == INDEX_SLICE))
+		return;
+
+	knn->nActive = nPt;
+	knn->active = safe_malloc(nPt * sizeof(int));
+	knn->dist = safe_malloc(nPt * sizeof(float));
+#ifdef _OPENMP
+	knn->nThread = omp_get_max_threads();
+#endif
+	knn->heap = safe_malloc(knn->nThread * par->minPts * sizeof(Epsn));
+	for (i = 0; i < nPt; ++ i)
+		knn->active[i] = i;
+}
+
 /*____________________________________________________________________________*/
 /* find next unprocessed point */
+/* Points are never unflagged during ordering, therefore the scan
+	resumes at the first point found unprocessed by the previous call. */
 static int find_next(OpticsDat *opticsdat)
 {
-	unsigned int i = 0;
+	unsigned int i = opticsdat->firstUnprocessed;
 
 	while (i < opticsdat->nPt){
-		if (opticsdat->pt[i].processed == 0)
+		if (opticsdat->pt[i].processed == 0) {
+			opticsdat->firstUnprocessed = i;
 			return i;
+		}
         ++ i;
     }
 
+	opticsdat->firstUnprocessed = i;
 	return -1; /* when all points are already processed */
 }
 
+/*____________________________________________________________________________*/
+/* add the epsilon neighbours of core point i to the seed list
+	or lower their key to the updated RD */
+static void update_seeds(Par *par, OpticsDat *opticsdat, int i, Knn *knn, SeedList *seeds)
+{
+	int c, k;
+
+	if (! is_core(par, opticsdat, i))
+		return;
+
+	if (knn->active != 0) {
+		for (c = 0; c < knn->nActive; ++ c) {
+			if (! (knn->dist[c] <= par->eps)) continue;
+			k = knn->active[c];
+			seedlist_update(seeds, k, opticsdat->pt[k].reachDist);
+		}
+	} else {
+		for (c = 0; c < opticsdat->pt[i].nEpsNeigh; ++ c) {
+			k = opticsdat->pt[i].epsNeigh[c].index;
+			seedlist_update(seeds, k, opticsdat->pt[k].reachDist);
+		}
+	}
+}
+
 /*____________________________________________________________________________*/
 /* order points */
 /* Algorithm (from Ref. 2.):
@@ -207,7 +640,7 @@ static int find_next(OpticsDat *opticsdat)
 		than the previous RD for that object, replace it with the current RD.
 	5. Go to 3 and continue until all objects are processed. */
 
-static int order(Dat *dat, Par *par, OpticsDat *opticsdat, int i, int *ptr_processed, Arg *arg)
+static int order(Dat *dat, Par *par, OpticsDat *opticsdat, int i, int *ptr_processed, NbIndex *nbindex, Knn *knn, SeedList *seeds, Prefetch *prefetch, Arg *arg)
 {
 	int next = -1;
     int perc;
@@ -223,21 +656,45 @@ static int order(Dat *dat, Par *par, OpticsDat *opticsdat, int i, int *ptr_proce
 
 	/* and its index recorded */
 	opticsdat->pt[i].index = i;
+	/* processed points are no neighbour candidates anymore */
+	neighbour_remove(nbindex, i);
 
-	/* Record unprocessed points in epsilon neighbourhood of point i. */
-	epsilon_neighbourhood(dat, par, opticsdat, i, arg);
-	/* Compute the CD (= core distance) of point i
-		and update the RD of points in its epsilon neighbourhood.
-		The returned point index 'next' is the closest neighbour of i. */
-	next = cd_rd(par, opticsdat, i);
+	if ((opticsdat->core != 0) && (! opticsdat->core[i])) {
+		/* no core point by its CD over all points: no RD to update */
+		opticsdat->pt[i].epsNeigh = 0;
+		opticsdat->pt[i].nEpsNeigh = 0;
+	} else if (knn->active != 0) {
+		/* infinite epsilon: CD and RD without neighbour list */
+		next = knn_cd_rd(dat, par, opticsdat, i, knn, arg);
+	} else {
+		/* Record unprocessed points in epsilon neighbourhood of point i,
+			possibly computed in parallel with the likely next points. */
+		if (! prefetch_neighbourhood(prefetch, dat, par, opticsdat, i, nbindex, arg))
+			epsilon_neighbourhood(dat, par, opticsdat, i, nbindex, arg);
+		/* Compute the CD (= core distance) of point i
+			and update the RD of points in its epsilon neighbourhood.
+			The returned point index 'next' is the closest neighbour of i. */
+		next = cd_rd(par, opticsdat, i);
+	}
 
-    /* empty the neighbour list to save memory */
-	free(opticsdat->pt[i].epsNeigh);
+	/* global ordering (Ankerst et al.): the next point is the one
+		with the lowest RD among all points reached so far */
+	if (seeds->heap != 0) {
+		update_seeds(par, opticsdat, i, knn, seeds);
+		next = seedlist_pop(seeds);
+	}
 
 	/* if CD and RD undefined, find next point to process */
 	if (next < 0)
 		next = find_next(opticsdat);
 
+	/* empty the neighbour list to save memory */
+	if (knn->active == 0) {
+		/* neighbours with low RD are likely to follow 'next' */
+		prefetch_guess(prefetch, par, opticsdat, i, next);
+		free(opticsdat->pt[i].epsNeigh);
+	}
+
 	return next;
 }
 
@@ -248,7 +705,6 @@ static int order(Dat *dat, Par *par, OpticsDat *opticsdat, int i, int *ptr_proce
 void order_by_RD(Pt **RD_ordered_data, Pt **ordered_data, int first, int last)
 {
     int i, npoints;
-	int (*fcmp)() = &compare_RD_deref;
 
     /* number of points to order */
     npoints = last - first + 1;
@@ -258,8 +714,9 @@ void order_by_RD(Pt **RD_ordered_data, Pt **ordered_data, int first, int last)
         RD_ordered_data[i] = ordered_data[i + first];
     }
 
-    /* sort ordered vector by RD */
-    MergeSort((void *)RD_ordered_data, npoints, sizeof(Pt *), fcmp);
+    /* sort ordered vector by RD; the sort is stable:
+        points of equal RD remain in OPTICS order */
+    sort_RD(RD_ordered_data, npoints);
 }
 
 /*____________________________________________________________________________*/
@@ -358,29 +815,62 @@ void extract_root_clusters(ClusterList *cluster_list, Pt **RD_ordered_data, Pt *
 }
 
 /*____________________________________________________________________________*/
-/* extract sub clusters */
+/* append 'cluster' to 'cluster_list'; thread-safe */
+static void append_cluster(ClusterList *cluster_list, Cluster *cluster, int *ptr_mem_allocated, int *ptr_pseudoClusterFlag)
+{
+	#pragma omp critical (cluster_list)
+	{
+		cluster_list->cluster[cluster_list->nCluster] = *cluster;
+
+		/* if cluster has no valid representative raise a flag */
+		if (cluster->minCDid == -1) {
+			(*ptr_pseudoClusterFlag) = 1;
+		}
+
+		/* increase cluster counts */
+		cluster_list->nCluster ++;
+
+		/* allocate more memory if needed */
+		if (cluster_list->nCluster == (*ptr_mem_allocated)) {
+			(*ptr_mem_allocated) += 10;
+			cluster_list->cluster = safe_realloc(cluster_list->cluster, (*ptr_mem_allocated) * sizeof(Cluster));
+		}
+	}
+}
+
+/*____________________________________________________________________________*/
+/* extract the sub clusters of 'cluster' (number 'parent_id') and append them
+	to 'cluster_list'; 'cluster' must not point into 'cluster_list', which
+	may be reallocated by concurrent calls for other clusters. The processed
+	flags are local, so that calls for different clusters are independent.
+	Returns the number of sub clusters. */
 int extract_sub_clusters(Cluster *cluster, ClusterList * cluster_list, Pt **ordered_data, int parent_id, Par *par, int *ptr_mem_allocated, int *ptr_pseudoClusterFlag)
 {
     int i, j; /* counters */
     int start, end, npoints; /* start index, end index and number of points */
     Pt **cluster_RD_ordered_data; /* list of RD ordered data (cluster) */
+    char *processed; /* processed flag of the cluster points, in order */
     Pt *clStart = NULL; /* start cluster point */
+    Cluster subcluster; /* sub cluster */
     float minCD; /*  min CD in the cluster */
     int minCDid; /* id of point with minCD */
     float diff;
     int cluster_size; /* size of subcluster */
-    int firstNewCluster = -1; /* index of first new cluster */
+    int nSubCluster = 0; /* number of sub clusters */
 
     start = cluster->start;
     end = cluster->end;
     npoints = end - start + 1;
 
     cluster_RD_ordered_data = safe_malloc(npoints * sizeof(Pt *));
+    processed = safe_malloc(npoints * sizeof(char));
 
     order_by_RD(cluster_RD_ordered_data, ordered_data, start, end);
 
     /* reset processed flag */
-    reset_processed_flag(cluster_RD_ordered_data, npoints);
+    for (i = 0; i < npoints; ++ i) {
+        processed[i] = 0;
+	}
 
     /* start with highest RD point */
     /* WARNING: sorting should be stable
@@ -389,7 +879,7 @@ int extract_sub_clusters(Cluster *cluster, ClusterList * cluster_list, Pt **orde
     clStart = cluster_RD_ordered_data[0];
 
 	for (i = 1; i < npoints; ++ i) {
-        if ((*cluster_RD_ordered_data[i]).processed == 1) {
+        if (processed[(*cluster_RD_ordered_data[i]).order - start] == 1) {
             continue;
 		}
         /* calculate RD diff between points */
@@ -401,12 +891,7 @@ int extract_sub_clusters(Cluster *cluster, ClusterList * cluster_list, Pt **orde
             if (    /* cluster should include at least MinPts objects */
                     (cluster_size > par->minPts) &
                     /* cluster should be at least MinPts smaller than parent cluster */
-                    ((cluster_list->cluster[parent_id].size - cluster_size ) >= par->minPts )) { 
-
-                /*update first new cluster index */
-                if (firstNewCluster == -1) {
-                    firstNewCluster = cluster_list->nCluster;
-				}
+                    ((cluster->size - cluster_size ) >= par->minPts )) { 
 
                 /* set minCD to highest value */
                 minCD = par->eps + 1; 
@@ -414,7 +899,7 @@ int extract_sub_clusters(Cluster *cluster, ClusterList * cluster_list, Pt **orde
 
                 for (j = (*clStart).order; j < (*cluster_RD_ordered_data[i]).order; ++j) {
                     /* mark cluster point as processed */
-                    (*ordered_data[j]).processed = 1;
+                    processed[j - start] = 1;
                     /* get minCD and minCDid */
                     if ((*ordered_data[j]).coreDist < minCD) {
                         minCD = (*ordered_data[j]).coreDist;
@@ -423,27 +908,16 @@ int extract_sub_clusters(Cluster *cluster, ClusterList * cluster_list, Pt **orde
                 }
 
                 /* add cluster to list */
-                cluster_list->cluster[cluster_list->nCluster].start = (*clStart).order;
+                subcluster.start = (*clStart).order;
                 /* last cluster point is set to i - 1 */
-                cluster_list->cluster[cluster_list->nCluster].end = (*cluster_RD_ordered_data[i]).order - 1;
-                cluster_list->cluster[cluster_list->nCluster].size = cluster_size; 
-                cluster_list->cluster[cluster_list->nCluster].parent = parent_id;
-                cluster_list->cluster[cluster_list->nCluster].minCD = minCD;
-                cluster_list->cluster[cluster_list->nCluster].minCDid = minCDid;
-
-                /* if cluster has no valid representative raise a flag */
-                if (minCDid == -1) {
-                    (*ptr_pseudoClusterFlag) = 1;
-				}
+                subcluster.end = (*cluster_RD_ordered_data[i]).order - 1;
+                subcluster.size = cluster_size; 
+                subcluster.parent = parent_id;
+                subcluster.minCD = minCD;
+                subcluster.minCDid = minCDid;
+                append_cluster(cluster_list, &subcluster, ptr_mem_allocated, ptr_pseudoClusterFlag);
+                ++ nSubCluster;
 
-                /* increase cluster counts */
-                cluster_list->nCluster ++;
-
-                /* allocate more memory if needed */
-                if (cluster_list->nCluster == (*ptr_mem_allocated)) {
-                    (*ptr_mem_allocated) += 10;
-                    cluster_list->cluster = safe_realloc(cluster_list->cluster, (*ptr_mem_allocated) * sizeof(Cluster));
-                }
                 /* next starting point is the actual left hand side */
                 clStart = cluster_RD_ordered_data[i];
             }
@@ -451,168 +925,664 @@ int extract_sub_clusters(Cluster *cluster, ClusterList * cluster_list, Pt **orde
     }
 
     free(cluster_RD_ordered_data);
+    free(processed);
 
-    return(firstNewCluster);
+    return(nSubCluster);
 }
 
 /*____________________________________________________________________________*/
-int main(int argc, char *argv[])
+/** sub cluster a before b in the numbering of the serial extraction */
+__inline__ static int before_cluster(Cluster a, Cluster b)
 {
-	unsigned int i = 0; /* index */
+	return ((a.parent < b.parent) || ((a.parent == b.parent) && (a.start < b.start)));
+}
 
-    Arg arg; /** data structure for command line arguments */
-	Dat dat; /* input data */
-	Par par; /* ordering parameters */
+/* sort clusters by parent, then by start */
+MERGESORT_DEFINE(sort_cluster, Cluster, before_cluster)
+
+/*____________________________________________________________________________*/
+/* extract the sub clusters of all clusters in 'cluster_list' */
+/* The clusters are extracted level by level: the worklist is the clusters
+	found in the previous level (the root clusters first), and their sub
+	clusters are extracted concurrently, because clusters of one level
+	cover disjoint parts of the ordering. Sub clusters are appended in the
+	order in which the threads find them; sorting the new clusters by
+	parent and start restores the numbering of a serial breadth-first
+	extraction, independent of the number of threads. */
+void extract_sub_clusters_all(ClusterList *cluster_list, Pt **ordered_data, Par *par, int *ptr_mem_allocated, int *ptr_pseudoClusterFlag)
+{
+	int w; /* worklist index */
+	int first = 0; /* first cluster of the current level */
+	int nWork; /* number of clusters of the current level */
+	Cluster *work = 0; /* clusters of the current level */
+
+	while (first < cluster_list->nCluster) {
+		/* copy the worklist: the cluster list grows during extraction */
+		nWork = cluster_list->nCluster - first;
+		work = safe_realloc(work, nWork * sizeof(Cluster));
+		memcpy(work, &(cluster_list->cluster[first]), nWork * sizeof(Cluster));
+
+		/* a single cluster sorts its points on all threads instead */
+		#pragma omp parallel for schedule(dynamic, 1) if (nWork > 1)
+		for (w = 0; w < nWork; ++ w)
+			extract_sub_clusters(&(work[w]), cluster_list, ordered_data, first + w, par, ptr_mem_allocated, ptr_pseudoClusterFlag);
+
+		/* deterministic numbering of the new clusters */
+		sort_cluster(&(cluster_list->cluster[first + nWork]), cluster_list->nCluster - (first + nWork));
+		first += nWork;
+	}
+
+	free(work);
+}
+
+/*____________________________________________________________________________*/
+/* extract the sub clusters of all clusters in 'cluster_list' with range
+	queries on the ordering instead of sorting each cluster by RD; the
+	clusters, their numbering and minCD are those of extract_sub_clusters_all() */
+/* extract_sub_clusters() visits the cluster points by decreasing RD and
+	accepts an RD increase (up point) q as the end of the next sub cluster
+	[clStart, q - 1] if q lies in the window [clStart + minPts + 1,
+	clStart + size - minPts]; clStart moves to q. Accepted points follow
+	each other in the RD order, so the next one is the highest up point
+	in the window that comes after the current one. Only the first window
+	(from the highest RD point) can end before the cluster end; up points
+	beyond it with higher RD than the first accepted point are skipped
+	later, and there are fewer than minPts of them. */
+void extract_sub_clusters_rmq(ClusterList *cluster_list, Pt **ordered_data, int npoints, Par *par, int *ptr_mem_allocated, int *ptr_pseudoClusterFlag)
+{
+	int i, j, q, t; /* indices */
+	int start, end, size; /* cluster range and size */
+	int clStart; /* start of the next sub cluster */
+	int first, last, firstEnd; /* query window, end of the first window */
+	float *rd = safe_malloc(npoints * sizeof(float)); /* RDs in order */
+	float *up = safe_malloc(npoints * sizeof(float)); /* RD of up points */
+	float *cd = safe_malloc(npoints * sizeof(float)); /* CDs in order */
+	float minCD0 = par->eps + 1; /* CD of noise points */
+	Rmq rdMax, upMax, cdMin; /* range queries */
+
+	for (i = 0; i < npoints; ++ i) {
+		rd[i] = (*ordered_data[i]).reachDist;
+		cd[i] = (*ordered_data[i]).coreDist;
+		/* an RD increase with respect to the previous point */
+		up[i] = ((i > 0) && (rd[i] > rd[i - 1])) ? rd[i] : -FLT_MAX;
+	}
+	rmq_init(&rdMax, rd, npoints, 1);
+	rmq_init(&upMax, up, npoints, 1);
+	rmq_init(&cdMin, cd, npoints, 0);
+
+	/* clusters in the order of the worklist of extract_sub_clusters_all() */
+	for (i = 0; i < cluster_list->nCluster; ++ i) {
+		start = cluster_list->cluster[i].start;
+		end = cluster_list->cluster[i].end;
+		size = cluster_list->cluster[i].size;
+
+		/* start with highest RD point */
+		clStart = rmq_query(&rdMax, start, end);
+		firstEnd = clStart + size - par->minPts;
+
+		while (1) {
+			first = clStart + par->minPts + 1;
+			last = (clStart + size - par->minPts < end) ? clStart + size - par->minPts : end;
+			if (first > last)
+				break;
+
+			/* highest up point in the window, within the first window */
+			q = -1;
+			if (first <= ((last < firstEnd) ? last : firstEnd)) {
+				q = rmq_query(&upMax, first, (last < firstEnd) ? last : firstEnd);
+				if (up[q] == -FLT_MAX)
+					q = -1;
+			}
+			/* up points beyond the first window that come after clStart */
+			for (t = (first > firstEnd + 1) ? first : firstEnd + 1; t <= last; ++ t) {
+				if ((up[t] == -FLT_MAX) || (up[t] > rd[clStart]))
+					continue;
+				if ((q < 0) || (up[t] > up[q]))
+					q = t;
+			}
+			if (q < 0)
+				break;
+
+			/* add cluster [clStart, q - 1] to list */
+			cluster_list->cluster[cluster_list->nCluster].start = clStart;
+			cluster_list->cluster[cluster_list->nCluster].end = q - 1;
+			cluster_list->cluster[cluster_list->nCluster].size = q - clStart;
+			cluster_list->cluster[cluster_list->nCluster].parent = i;
+			j = rmq_query(&cdMin, clStart, q - 1);
+			if (cd[j] < minCD0) {
+				cluster_list->cluster[cluster_list->nCluster].minCD = cd[j];
+				cluster_list->cluster[cluster_list->nCluster].minCDid = (*ordered_data[j]).order;
+			} else {
+				cluster_list->cluster[cluster_list->nCluster].minCD = minCD0;
+				cluster_list->cluster[cluster_list->nCluster].minCDid = -1;
+				/* cluster has no valid representative */
+				(*ptr_pseudoClusterFlag) = 1;
+			}
+
+			/* increase cluster counts */
+			cluster_list->nCluster ++;
+
+			/* allocate more memory if needed */
+			if (cluster_list->nCluster == (*ptr_mem_allocated)) {
+				(*ptr_mem_allocated) += 10;
+				cluster_list->cluster = safe_realloc(cluster_list->cluster, (*ptr_mem_allocated) * sizeof(Cluster));
+			}
+
+			/* next starting point is the actual left hand side */
+			clStart = q;
+		}
+	}
+
+	rmq_free(&rdMax);
+	rmq_free(&upMax);
+	rmq_free(&cdMin);
+	free(rd);
+	free(up);
+	free(cd);
+}
+
+/*____________________________________________________________________________*/
+/** output file record of ordered point i */
+static char *format_point(char *s, int i, void *data)
+{
+	Pt *pt = ((Output *)data)->ordered_data[i];
+
+	s = format_int(s, pt->index, 10, ' ');
+	s = format_float(s, pt->coreDist, 8, ' ');
+	return format_float(s, pt->reachDist, 8, '\n');
+}
+
+/*____________________________________________________________________________*/
+/** cluster file record of the i-th cluster to write */
+static char *format_cluster(char *s, int i, void *data)
+{
+	Output *output = (Output *)data;
+	int id = output->id[i];
+	Cluster *cluster = &(output->cluster_list->cluster[id]);
+
+	s = format_int(s, id, 4, ' ');
+	s = format_int(s, cluster->parent, 8, ' ');
+	s = format_int(s, cluster->start, 8, ' ');
+	s = format_int(s, cluster->end, 8, ' ');
+	s = format_int(s, cluster->size, 8, ' ');
+	s = format_float(s, cluster->minCD, 8, ' ');
+	return format_int(s, cluster->minCDid, 8, '\n');
+}
+
+/*____________________________________________________________________________*/
+/** center file record of the i-th cluster to write: its center point */
+static char *format_center(char *s, int i, void *data)
+{
+	Output *output = (Output *)data;
+	int id = output->id[i];
+	Pt *center = output->ordered_data[output->cluster_list->cluster[id].minCDid];
+
+	return format_object(s, output->dat, center->index, center->order, id, center->coreDist, center->reachDist);
+}
+
+/*____________________________________________________________________________*/
+/* order the points with the parameters 'par', extract clusters and write
+	the output files, with 'prefix' prepended to the file names;
+	'nbcache' holds the cached epsilon neighbourhoods or is 0;
+	returns 1 if no clusters are found, otherwise 0 */
+static int optics_run(Dat *dat, Par *par, NbIndex *nbcache, Arg *arg, char *prefix)
+{
+	unsigned int i = 0; /* index */
+	int k; /* point index */
 	OpticsDat opticsdat; /* optics data points */
+	NbIndex index; /* neighbour search index */
+	NbIndex *nbindex = &index; /* neighbour search index or cache */
+	Knn knn; /* bounded neighbour search for infinite epsilon */
+	Prefetch prefetch; /* speculative neighbourhoods of likely next points */
+	SeedList seeds; /* seed list for global ordering */
+	State state; /* ordering state of a previous run */
+	char *removed = 0; /* flag for points removed from the data set */
+	float *coreDist = 0; /* core distances over all points */
+	FILE *cdFile = 0; /* core distance file handle */
+	int nRemoved = 0; /* number of removed points */
+	int nOrdered = 0; /* number of ordered points */
     int processed = 0; /*  of processed */
     Pt **ordered_data; /* list of ordered data */
     Pt **RD_ordered_data; /* list of RD ordered data */
-	int next = 0; /* index of first point */
+	int next = -1; /* index of first point */
     ClusterList cluster_list; /* cluster list */
     int mem_allocated; /* memory counter for cluster list */
-    int firstNewCluster = 0; /* index of first new cluster */
     int pseudoClusterFlag = 0; /* pseudo cluster flag */
     char pseudoClusterOutFileName[128] = "pseudo."; /* pseudo cluster file name */
     FILE *pseudoClusterOutFile = 0; /* pseudo cluster file handle */
+	Output output; /* output data */
+	int *center = 0, *unique = 0, *pseudo = 0; /* clusters to write */
+	int nCenter = 0, nUnique = 0, nPseudo = 0; /* number of clusters to write */
 	char outName[256] = "";
-    
-    /*____________________________________________________________________________*/
-    /** parse command line arguments */
-    parse_args(argc, &(argv[0]), &arg);
 
-	/*____________________________________________________________________________*/
-	/* parametrise */
-	par.eps = arg.eps; /* order: neighbourhood radius */
-	par.minPts = arg.minPts; /* order: minimum number of objects in neighbourhood */
-
-	/*____________________________________________________________________________*/
-	/** read input data */
-	get_data(arg.dataInFileName, &dat);
-    if (! silent) 
-        fprintf(stderr, "%d points\n", dat.nData);
-	opticsdat.nPt = dat.nData;
+	opticsdat.nPt = dat->nData;
 
-	/*____________________________________________________________________________*/
-	/** perform ordering */
 	/* allocate memory to points */
 	opticsdat.pt = safe_malloc(opticsdat.nPt * sizeof(Pt));	
     ordered_data = safe_malloc(opticsdat.nPt * sizeof(Pt *));
     RD_ordered_data = safe_malloc(opticsdat.nPt * sizeof(Pt *));
 
 	/* initialise optics data points */
-	initialise(&opticsdat, &par);
+	initialise(&opticsdat, par);
 
-	/* the RD of the first point is undefined and set to eps */
-    /* see Daszykowski et al. for details */
-	opticsdat.pt[next].reachDist = par.eps;
-
-	/* order the points */
-    while (next != -1) {
-        /* the point is added to the order list */
-        ordered_data[i] = &(opticsdat.pt[next]);
-        /* and its order attribute is updated */
-        opticsdat.pt[next].order = i;
-        /* Compute CD and RD then return point index 'next' of closest neighbour */
-        next = order(&dat, &par, &opticsdat, next, &processed, &arg);
-        i ++; 
-    }
+	if (arg->order == ORDER_MST) {
+		/* order along the minimum spanning tree */
+		mst_order(dat, par, &opticsdat, ordered_data, arg);
+		nOrdered = opticsdat.nPt;
+	} else {
+		/* points excluded from the ordering */
+		removed = safe_malloc(opticsdat.nPt * sizeof(char));
+		for (i = 0; i < opticsdat.nPt; ++ i)
+			removed[i] = 0;
+		if (arg->removedFileName != 0)
+			state_removed(arg->removedFileName, removed, opticsdat.nPt);
+		if (arg->resumeFileName != 0)
+			state_read(arg->resumeFileName, &state, dat, par, arg);
+
+		/* build neighbour search index unless neighbourhoods are cached */
+		if (nbcache != 0) {
+			nbindex = nbcache;
+			nbindex->nRemoved = 0;
+		} else {
+			neighbour_init(nbindex, dat, par, arg);
+		}
+		knn_init(&knn, par, nbindex, opticsdat.nPt);
+		prefetch_init(&prefetch, arg->prefetch, opticsdat.nPt, nbindex);
+		if (arg->order == ORDER_GLOBAL) {
+			seedlist_init(&seeds, opticsdat.nPt);
+		} else {
+			seeds.heap = 0;
+			seeds.pos = 0;
+			seeds.key = 0;
+		}
 
-	/* order the points by RD */
-    order_by_RD(RD_ordered_data, ordered_data, 0, (opticsdat.nPt - 1));
+		/* core distances over all points, computed up front in parallel;
+			the ordering then only updates reachability distances */
+		if (arg->coreDist == COREDIST_ALL) {
+			coreDist = safe_malloc(opticsdat.nPt * sizeof(float));
+			opticsdat.core = safe_malloc(opticsdat.nPt * sizeof(char));
+			mst_core_distances(dat, par, coreDist, opticsdat.core, arg);
+			for (k = 0; k < opticsdat.nPt; ++ k)
+				opticsdat.pt[k].coreDist = coreDist[k];
+			free(coreDist);
+		}
 
-    /* reset processed flag */
-    reset_processed_flag(RD_ordered_data, opticsdat.nPt);
+		/* incremental update: keep the unchanged part of the previous ordering */
+		i = 0;
+		if (arg->resumeFileName != 0) {
+			i = state_resume(&state, dat, par, &opticsdat, ordered_data, removed, nbindex, &seeds, arg, &next);
+			state_free(&state);
+		}
+
+		/* removed points are never processed */
+		for (k = 0; k < opticsdat.nPt; ++ k) {
+			if (removed[k]) {
+				opticsdat.pt[k].processed = 1;
+				neighbour_remove(nbindex, k);
+				++ nRemoved;
+			}
+		}
+		processed = i + nRemoved;
+
+		/* first point: the lowest unprocessed index unless resumed */
+		if ((next < 0) && (seeds.heap != 0))
+			next = seedlist_pop(&seeds);
+		if (next < 0)
+			next = find_next(&opticsdat);
+
+		/* the RD of the first point is undefined and set to eps */
+		/* see Daszykowski et al. for details */
+		if ((i == 0) && (next >= 0))
+			opticsdat.pt[next].reachDist = par->eps;
+
+		/* order the points */
+		while (next != -1) {
+			/* the point is added to the order list */
+			ordered_data[i] = &(opticsdat.pt[next]);
+			/* and its order attribute is updated */
+			opticsdat.pt[next].order = i;
+			/* Compute CD and RD then return point index 'next' of closest neighbour */
+			next = order(dat, par, &opticsdat, next, &processed, nbindex, &knn, &seeds, &prefetch, arg);
+			i ++; 
+		}
+		nOrdered = i;
+
+		/* the search index is not needed after ordering */
+		if (nbcache == 0) {
+			neighbour_report(nbindex);
+			neighbour_free(nbindex);
+		}
+		prefetch_report(&prefetch);
+		prefetch_free(&prefetch);
+		free(knn.active);
+		free(knn.dist);
+		free(knn.heap);
+		seedlist_free(&seeds);
+		free(removed);
+		free(opticsdat.core);
+
+		if (nOrdered == 0) {
+			fprintf(stderr, "No points left to order\n");
+			exit(1);
+		}
+	}
+
+	/* core distances of the ordered points */
+	if (arg->cdFileName != 0) {
+		sprintf(outName, "%s/%s%s", arg->outPathName, prefix, arg->cdFileName);
+		cdFile = safe_open(outName, "w");
+		fprintf(cdFile, "    dataId       CD\n");
+		for (k = 0; k < opticsdat.nPt; ++ k)
+			if (opticsdat.pt[k].index >= 0)
+				fprintf(cdFile, "%10d %8.3f\n", k, opticsdat.pt[k].coreDist);
+		fclose(cdFile);
+	}
+
+	/* state for incremental updates */
+	if (arg->stateFileName != 0) {
+		sprintf(outName, "%s%s", prefix, arg->stateFileName);
+		state_write(outName, ordered_data, nOrdered, opticsdat.nPt, par, arg);
+	}
 
     /* initialise cluster list */
     cluster_list.nCluster = 0;
 
-    /* extract root clusters */
-    extract_root_clusters(&cluster_list, RD_ordered_data, ordered_data, opticsdat.nPt, &par, &mem_allocated, &pseudoClusterFlag);
+	if (arg->extract == EXTRACT_XI) {
+		/* complete cluster hierarchy from steep areas of the RD plot */
+		extract_clusters_xi(&cluster_list, ordered_data, nOrdered, par, arg->xi, &mem_allocated, &pseudoClusterFlag);
+	} else {
+		/* order the points by RD */
+		order_by_RD(RD_ordered_data, ordered_data, 0, (nOrdered - 1));
+
+		/* reset processed flag */
+		reset_processed_flag(RD_ordered_data, nOrdered);
+
+		/* extract root clusters */
+		extract_root_clusters(&cluster_list, RD_ordered_data, ordered_data, nOrdered, par, &mem_allocated, &pseudoClusterFlag);
+	}
 
     /* extract subclusters */
-	if (cluster_list.nCluster > 0) {
-		while(firstNewCluster != -1)
-			for (i = firstNewCluster; i < cluster_list.nCluster; ++i)
-				firstNewCluster = extract_sub_clusters(&(cluster_list.cluster[i]), &cluster_list, ordered_data, i, &par, &mem_allocated, &pseudoClusterFlag);
-    } else {
+	if ((cluster_list.nCluster > 0) && (arg->extract == EXTRACT_RMQ)) {
+		extract_sub_clusters_rmq(&cluster_list, ordered_data, nOrdered, par, &mem_allocated, &pseudoClusterFlag);
+	} else if ((cluster_list.nCluster > 0) && (arg->extract == EXTRACT_SORT)) {
+		extract_sub_clusters_all(&cluster_list, ordered_data, par, &mem_allocated, &pseudoClusterFlag);
+    } else if (cluster_list.nCluster == 0) {
         fprintf(stderr, "No clusters found! Try larger 'epsilon' or smaller 'minpts'\n");
-        exit(1);
+        free(opticsdat.pt);
+        free(ordered_data);
+        free(RD_ordered_data);
+        return 1;
     }   
 
     /* open output files */
 	/* concatenate path and file name */
-	sprintf(outName, "%s/%s", arg.outPathName, arg.dataOutFileName);
-    arg.dataOutFile = safe_open(outName, "w");
-	sprintf(outName, "%s/%s", arg.outPathName, arg.clusterOutFileName);
-    arg.clusterOutFile = safe_open(outName, "w");
-	sprintf(outName, "%s/%s", arg.outPathName, arg.centerOutFileName);
-    arg.centerOutFile = safe_open(outName, "w");
-	sprintf(outName, "%s/%s", arg.outPathName, arg.uniqueOutFileName);
-    arg.uniqueOutFile = safe_open(outName, "w");
+	sprintf(outName, "%s/%s%s", arg->outPathName, prefix, arg->dataOutFileName);
+    arg->dataOutFile = safe_open(outName, "w");
+	sprintf(outName, "%s/%s%s", arg->outPathName, prefix, arg->clusterOutFileName);
+    arg->clusterOutFile = safe_open(outName, "w");
+	sprintf(outName, "%s/%s%s", arg->outPathName, prefix, arg->centerOutFileName);
+    arg->centerOutFile = safe_open(outName, "w");
+	sprintf(outName, "%s/%s%s", arg->outPathName, prefix, arg->uniqueOutFileName);
+    arg->uniqueOutFile = safe_open(outName, "w");
     /* open pseudo cluster file if needed */
     if (pseudoClusterFlag != 0){
-		sprintf(outName, "%s/%s%s",
-			arg.outPathName, pseudoClusterOutFileName, arg.clusterOutFileName);
+		sprintf(outName, "%s/%s%s%s",
+			arg->outPathName, pseudoClusterOutFileName, prefix, arg->clusterOutFileName);
         pseudoClusterOutFile = safe_open(outName, "w");
     }
 
     /* print ordered points */
     if (! silent)
         fprintf(stderr, "Sorting Completed\n\n");
-    fprintf(arg.dataOutFile, "    dataId       CD       RD\n");
-	for (i = 0; i < opticsdat.nPt; ++ i){
-        fprintf(arg.dataOutFile, "%10d %8.3f %8.3f\n", (*ordered_data[i]).index, (*ordered_data[i]).coreDist, (*ordered_data[i]).reachDist);
-    }
+    fprintf(arg->dataOutFile, "    dataId       CD       RD\n");
+	output.dat = dat;
+	output.ordered_data = ordered_data;
+	output.cluster_list = &cluster_list;
+	format_write(arg->dataOutFile, nOrdered, FORMAT_INT + 2 * FORMAT_FLOAT + 3, format_point, &output);
+
+    /* clusters with a valid center, i.e. at least one core point is in the
+     * cluster, those of them whose center differs from the parent center,
+     * and those without a valid center (pseudo clusters) */
+	center = safe_malloc((3 * cluster_list.nCluster) * sizeof(int));
+	unique = &(center[cluster_list.nCluster]);
+	pseudo = &(center[2 * cluster_list.nCluster]);
+    for (i = 0; i < cluster_list.nCluster;  ++i){
+        if (cluster_list.cluster[i].minCDid != -1) {
+			center[nCenter ++] = i;
+            if ((cluster_list.cluster[i].parent == -1) ||
+                (cluster_list.cluster[i].minCDid != cluster_list.cluster[cluster_list.cluster[i].parent].minCDid))
+				unique[nUnique ++] = i;
+        } else {
+			pseudo[nPseudo ++] = i;
+		}
+	}
 
     /* print clustering results */
-    fprintf(arg.clusterOutFile, "  id   parent    start      end     size    minCD  minCDid\n");
-    print_header_object(arg.centerOutFile);
-    print_header_object(arg.uniqueOutFile);
-    /* print header to pseudo cluster file if needed */
-    if (pseudoClusterFlag != 0)
+    fprintf(arg->clusterOutFile, "  id   parent    start      end     size    minCD  minCDid\n");
+    print_header_object(arg->centerOutFile);
+    print_header_object(arg->uniqueOutFile);
+	output.id = center;
+	format_write(arg->clusterOutFile, nCenter, 6 * FORMAT_INT + FORMAT_FLOAT + 7, format_cluster, &output);
+	format_write(arg->centerOutFile, nCenter, format_object_length(dat), format_center, &output);
+	output.id = unique;
+	format_write(arg->uniqueOutFile, nUnique, format_object_length(dat), format_center, &output);
+    /* print the info of clusters without valid center to pseudo cluster file */
+    if (pseudoClusterFlag != 0) {
         fprintf(pseudoClusterOutFile, "  id   parent    start      end     size    minCD  minCDid\n");
-    for (i = 0; i < cluster_list.nCluster;  ++i){
-        /* check if cluster has a valid center.
-         * i.e. at least one core point is in the cluster */
-        if (cluster_list.cluster[i].minCDid != -1) {
-            fprintf(arg.clusterOutFile, "%4d %8d %8d %8d %8d %8.3f %8d\n", i, cluster_list.cluster[i].parent, cluster_list.cluster[i].start, cluster_list.cluster[i].end, cluster_list.cluster[i].size, cluster_list.cluster[i].minCD, cluster_list.cluster[i].minCDid);
-            print_object(arg.centerOutFile, &dat, (*ordered_data[cluster_list.cluster[i].minCDid]).index, (*ordered_data[cluster_list.cluster[i].minCDid]).order,  i, (*ordered_data[cluster_list.cluster[i].minCDid]).coreDist, (*ordered_data[cluster_list.cluster[i].minCDid]).reachDist);
-            if (cluster_list.cluster[i].parent == -1)
-                print_object(arg.uniqueOutFile, &dat, (*ordered_data[cluster_list.cluster[i].minCDid]).index, (*ordered_data[cluster_list.cluster[i].minCDid]).order,  i, (*ordered_data[cluster_list.cluster[i].minCDid]).coreDist, (*ordered_data[cluster_list.cluster[i].minCDid]).reachDist);
-            else
-                if (cluster_list.cluster[i].minCDid != cluster_list.cluster[cluster_list.cluster[i].parent].minCDid)
-                    print_object(arg.uniqueOutFile, &dat, (*ordered_data[cluster_list.cluster[i].minCDid]).index, (*ordered_data[cluster_list.cluster[i].minCDid]).order,  i, (*ordered_data[cluster_list.cluster[i].minCDid]).coreDist, (*ordered_data[cluster_list.cluster[i].minCDid]).reachDist);
-        }else{
-            /* if the cluster has no valid center
-             * print the info in a pseudo cluster file */
-            fprintf(pseudoClusterOutFile, "%4d %8d %8d %8d %8d %8.3f %8d\n", i, cluster_list.cluster[i].parent, cluster_list.cluster[i].start, cluster_list.cluster[i].end, cluster_list.cluster[i].size, cluster_list.cluster[i].minCD, cluster_list.cluster[i].minCDid);
-        }
-    }
+		output.id = pseudo;
+		format_write(pseudoClusterOutFile, nPseudo, 6 * FORMAT_INT + FORMAT_FLOAT + 7, format_cluster, &output);
+	}
+	free(center);
+
+	/* close output files */
+	fclose(arg->dataOutFile);
+	fclose(arg->clusterOutFile);
+	fclose(arg->centerOutFile);
+	fclose(arg->uniqueOutFile);
+	/* close pseudo cluster file if needed */
+	if (pseudoClusterFlag != 0)
+		fclose(pseudoClusterOutFile);
+
+	free(opticsdat.pt);
+	free(ordered_data);
+	free(RD_ordered_data);
+	if (cluster_list.nCluster > 0)
+		free(cluster_list.cluster);
+
+	return 0;
+}
 
-    /* close output files */
-    fclose(arg.dataOutFile);
-    fclose(arg.clusterOutFile);
-    fclose(arg.centerOutFile);
-    fclose(arg.uniqueOutFile);
-    /* close pseudo cluster file if needed */
-    if (pseudoClusterFlag != 0)
-        fclose(pseudoClusterOutFile);
+/*____________________________________________________________________________*/
+/* run the ordering for each minPts value; with several values the
+	output file names get the prefix 'minpts<value>.' after 'prefix' */
+static int optics_minpts(Dat *dat, Par *par, NbIndex *nbcache, Arg *arg, char *prefix)
+{
+	int m; /* index of minPts value */
+	int status = 0; /* exit status */
+	char runPrefix[128] = ""; /* output file name prefix */
+
+	for (m = 0; m < arg->nMinPts; ++ m) {
+		par->minPts = arg->minPtsList[m];
+		/* one set of output files per minPts value */
+		if (arg->nMinPts > 1) {
+			sprintf(runPrefix, "%sminpts%d.", prefix, par->minPts);
+			if (! silent)
+				fprintf(stderr, "\nminpts %d\n", par->minPts);
+		} else {
+			sprintf(runPrefix, "%s", prefix);
+		}
+		status |= optics_run(dat, par, nbcache, arg, runPrefix);
+	}
+
+	return status;
+}
+
+#ifdef DATAXYZ
+/*____________________________________________________________________________*/
+/* streaming: order the last 'window' points of the input stream after
+	every 'stride' new points and at the end of the stream; the output
+	file names get the prefix 'window<first point>.' */
+static int optics_stream(Par *par, Arg *arg)
+{
+	int status = 0; /* exit status */
+	int nNew = 0; /* points read since the last ordering */
+	int nWindow = 0; /* number of ordered windows */
+	int cached = 0; /* flag for cached epsilon neighbourhoods */
+	Stream stream; /* sliding window */
+	Dat dat; /* window points */
+	NbIndex nbcache; /* epsilon neighbourhoods of the window points */
+	char prefix[64] = ""; /* output file name prefix */
+	FILE *inFile = (strcmp(arg->dataInFileName, "-") == 0) ?
+						stdin : safe_open(arg->dataInFileName, "r");
+
+	/* the spanning tree ordering computes its own distances */
+	stream_init(&stream, arg->window, (par->eps != FLT_MAX) && (arg->order != ORDER_MST));
+
+	while (1) {
+		if (stream_read(&stream, inFile, par, arg)) {
+			++ nNew;
+			/* wait for a full window, then for 'stride' new points */
+			if ((stream.nPt < arg->window) || ((nWindow > 0) && (nNew < arg->stride)))
+				continue;
+		} else if ((nNew == 0) || (stream.nPt < 2)) {
+			break;
+		}
+
+		if (! silent)
+			fprintf(stderr, "\nwindow of points %d to %d\n", stream.first, stream.first + stream.nPt - 1);
+		cached = stream_window(&stream, &dat, &nbcache);
+		sprintf(prefix, "window%d.", stream.first);
+		status |= optics_minpts(&dat, par, cached ? &nbcache : 0, arg, prefix);
+		if (cached)
+			neighbour_free(&nbcache);
+		free_xyz(&dat);
+		++ nWindow;
+		nNew = 0;
+	}
+
+	if (! silent)
+		fprintf(stderr, "%d windows ordered, %lld distance evaluations in the stream\n", nWindow, stream.nEval);
+
+	if (inFile != stdin)
+		fclose(inFile);
+	stream_free(&stream);
+
+	return status;
+}
+#endif
+
+/*____________________________________________________________________________*/
+int main(int argc, char *argv[])
+{
+	int status = 0; /* exit status */
+    Arg arg; /** data structure for command line arguments */
+	Dat dat; /* input data */
+	Par par; /* ordering parameters */
+	NbIndex nbcache; /* epsilon neighbourhoods shared by all minPts values */
+#if defined MPI && defined DATAXYZ
+	Slice slice; /* data points of this MPI rank */
+	int rank = 0; /* MPI rank */
+#else
+	int cached = 0; /* flag for cached epsilon neighbourhoods */
+#endif
+
+#if defined MPI && defined DATAXYZ
+	/*____________________________________________________________________________*/
+	/** start MPI */
+	MPI_Init(&argc, &argv);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	/* only rank 0 reports */
+	if (rank > 0)
+		silent = 1;
+#endif
+    
+    /*____________________________________________________________________________*/
+    /** parse command line arguments */
+    parse_args(argc, &(argv[0]), &arg);
+
+#ifdef _OPENMP
+	/* number of threads for parallel loops, by default all cores */
+	if (arg.nThread > 0)
+		omp_set_num_threads(arg.nThread);
+#endif
+
+	/*____________________________________________________________________________*/
+	/* parametrise */
+	par.eps = arg.eps; /* order: neighbourhood radius */
+	par.minPts = arg.minPts; /* order: minimum number of objects in neighbourhood */
+
+#ifdef DATAXYZ
+	/*____________________________________________________________________________*/
+	/** streaming: sliding window over the input points */
+	if (arg.window > 0) {
+		if (optics_stream(&par, &arg) != 0)
+			exit(1);
+		if (! silent)
+			fprintf(stderr, "Clean termination\n\n");
+		return 0;
+	}
+#endif
+
+#if defined MPI && defined DATAXYZ
+	/*____________________________________________________________________________*/
+	/** ranks other than 0 answer the range queries of rank 0 */
+	if (rank > 0) {
+		slice_init(&slice, 0, &par, &arg);
+		slice_serve(&slice, &par, &arg);
+		slice_free(&slice);
+		MPI_Finalize();
+		return 0;
+	}
+#endif
+
+	/*____________________________________________________________________________*/
+	/** read input data */
+	get_data(arg.dataInFileName, &dat);
+    if (! silent) 
+        fprintf(stderr, "%d points\n", dat.nData);
+
+	/*____________________________________________________________________________*/
+	/** perform ordering */
+#if defined MPI && defined DATAXYZ
+	/* distributed points: the ordering searches all ranks */
+	slice_init(&slice, &dat, &par, &arg);
+	slice_search(&slice, &nbcache);
+	status = optics_minpts(&dat, &par, &nbcache, &arg, "");
+	slice_stop(&slice);
+	slice_free(&slice);
+#else
+	/* several minPts values: the epsilon neighbourhoods do not depend on
+		minPts and are computed once for all orderings */
+	if ((arg.nMinPts > 1) && (arg.order != ORDER_MST) && (par.eps != FLT_MAX)) {
+		neighbour_init(&nbcache, &dat, &par, &arg);
+		neighbour_cache(&nbcache, &dat, &par, &arg);
+		cached = 1;
+	}
+
+	status = optics_minpts(&dat, &par, cached ? &nbcache : 0, &arg, "");
+
+	if (cached)
+		neighbour_free(&nbcache);
+#endif
 
 	/*____________________________________________________________________________*/
 	/** free memory */
 #ifdef DATADIST
 	free_mat2D_float(dat.dist, dat.nData);
+#elif defined DATAXYZ
+	free_xyz(&dat);
 #else
 	free(dat.data);
 #endif
-	free(opticsdat.pt);
-	free(ordered_data);
-	free(RD_ordered_data);
-    if (cluster_list.nCluster > 0)
-        free(cluster_list.cluster);
+
+	if (status != 0)
+		exit(1);
 
 	/*____________________________________________________________________________*/
 	/** terminate */
+#if defined MPI && defined DATAXYZ
+	MPI_Finalize();
+#endif
     if (! silent)
         fprintf(stderr, "Clean termination\n\n");
     return 0;
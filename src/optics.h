@@ -17,10 +17,14 @@ Read the COPYING file for license information.
 #include <float.h>
 #include <stdlib.h>
 #include <stdio.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "arg.h"
 #include "config.h"
 #include "safe.h"
+#include "seedlist.h"
 #include "sort.h"
 
 /* optional compilation of program */
@@ -72,10 +76,21 @@ typedef struct {
 	int nEpsNeigh; /* epsilon-neighbourhood: number of neighbour points */
 } Pt;
 
+/* bounded neighbour search for infinite epsilon */
+typedef struct {
+	int *active; /* unprocessed points in increasing index order */
+	int nActive; /* number of entries in active list */
+	float *dist; /* distances of active points to the current point */
+	Epsn *heap; /* max-heap of the minPts nearest neighbours, one per thread */
+	int nThread; /* number of heaps */
+} Knn;
+
 /* optics data */
 typedef struct {
 	Pt *pt; /* points */
 	int nPt; /* number of points */
+	int firstUnprocessed; /* all points with lower index are processed */
+	char *core; /* core point flags from CDs over all points, otherwise 0 */
 } OpticsDat;
 
 /* cluster */
@@ -94,4 +109,12 @@ typedef struct {
 	int nCluster; /* number of clusters */
 } ClusterList;
 
+/* output data */
+typedef struct {
+	Dat *dat; /* data points */
+	Pt **ordered_data; /* points in OPTICS order */
+	ClusterList *cluster_list; /* clusters */
+	int *id; /* clusters to write */
+} Output;
+
 #endif
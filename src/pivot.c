@@ -0,0 +1,128 @@
+/*==============================================================================
+pivot.c : pivot table (LAESA) for range queries in metric spaces
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The distances of all points to a small set of pivots are computed once.
+	For a metric, |d(i,p) - d(j,p)| is a lower bound of d(i,j), therefore
+	point j can be discarded as neighbour of i without evaluating d(i,j)
+	if the bound exceeds the search radius for any pivot p. */
+
+#include "pivot.h"
+
+/* Float rounding can violate the triangle inequality by a few units in the
+	last place, relative to the distances involved; the pruning bound is
+	widened by TOL accordingly. */
+#define TOL 1.0e-4
+
+/*____________________________________________________________________________*/
+/** build table of distances to 'nPivot' pivots; pivots are selected
+	farthest-first: each new pivot maximises the minimal distance
+	to the previous pivots */
+void pivot_build(PivotTable *pt, Dat *dat, int nPivot, Arg *arg)
+{
+	int j, k;
+	float *minDist = 0;
+
+	if (nPivot > dat->nData)
+		nPivot = dat->nData;
+
+	pt->nPt = dat->nData;
+	pt->nPivot = nPivot;
+	pt->pivot = safe_malloc(nPivot * sizeof(int));
+	pt->table = safe_malloc(pt->nPt * nPivot * sizeof(float));
+	pt->next = safe_malloc(pt->nPt * sizeof(int));
+	pt->prev = safe_malloc(pt->nPt * sizeof(int));
+	pt->first = 0;
+	pt->nEval = 0;
+	pt->nTested = 0;
+	pt->nPruned = 0;
+	minDist = safe_malloc(pt->nPt * sizeof(float));
+
+	/* all points are active, linked in index order */
+	for (j = 0; j < pt->nPt; ++ j) {
+		pt->next[j] = j + 1;
+		pt->prev[j] = j - 1;
+		minDist[j] = FLT_MAX;
+	}
+
+	for (k = 0, pt->pivot[0] = 0; k < nPivot; ++ k) {
+		for (j = 0; j < pt->nPt; ++ j) {
+			pt->table[j * nPivot + k] = calc_dist(dat, j, pt->pivot[k], arg);
+			if (pt->table[j * nPivot + k] < minDist[j])
+				minDist[j] = pt->table[j * nPivot + k];
+		}
+		pt->nEval += pt->nPt;
+
+		/* next pivot: farthest point from all current pivots */
+		if (k + 1 < nPivot) {
+			for (j = 1, pt->pivot[k + 1] = 0; j < pt->nPt; ++ j)
+				if (minDist[j] > minDist[pt->pivot[k + 1]])
+					pt->pivot[k + 1] = j;
+		}
+	}
+
+	free(minDist);
+}
+
+/*____________________________________________________________________________*/
+/** collect active points not excluded by the pivots from the 'radius'
+	neighbourhood of point i in 'cand', in increasing index order;
+	returns the number of candidates */
+int pivot_range(PivotTable *pt, int i, float radius, int **cand, int *allocated)
+{
+	int j, k;
+	int nCand = 0;
+	float *ti = &(pt->table[i * pt->nPivot]);
+	float *tj = 0;
+
+	for (j = pt->first; j < pt->nPt; j = pt->next[j]) {
+		tj = &(pt->table[j * pt->nPivot]);
+		for (k = 0; k < pt->nPivot; ++ k)
+			if (fabs(ti[k] - tj[k]) > radius + TOL * (ti[k] + tj[k] + radius))
+				break;
+		++ pt->nTested;
+		if (k < pt->nPivot) {
+			++ pt->nPruned;
+			continue;
+		}
+
+		(*cand)[nCand ++] = j;
+		/* allocate more space to candidate array if needed */
+		if (nCand == *allocated) {
+			*allocated += 64;
+			*cand = safe_realloc(*cand, *allocated * sizeof(int));
+		}
+	}
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** remove point i from all subsequent range searches */
+void pivot_remove(PivotTable *pt, int i)
+{
+	/* removed points are unlinked and marked by prev = -2 */
+	if (pt->prev[i] == -2)
+		return;
+
+	if (pt->prev[i] >= 0)
+		pt->next[pt->prev[i]] = pt->next[i];
+	else
+		pt->first = pt->next[i];
+	if (pt->next[i] < pt->nPt)
+		pt->prev[pt->next[i]] = pt->prev[i];
+	pt->prev[i] = -2;
+}
+
+/*____________________________________________________________________________*/
+/** free table memory */
+void pivot_free(PivotTable *pt)
+{
+	free(pt->pivot);
+	free(pt->table);
+	free(pt->next);
+	free(pt->prev);
+}
+
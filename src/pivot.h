@@ -0,0 +1,39 @@
+/*==============================================================================
+pivot.h : pivot table (LAESA) for range queries in metric spaces
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef PIVOT_H
+#define PIVOT_H
+
+#include <math.h>
+
+#include "optics.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* pivot table */
+typedef struct {
+	int nPt; /* number of points */
+	int nPivot; /* number of pivots */
+	int *pivot; /* pivot points */
+	float *table; /* distances of points to pivots: nPt * nPivot */
+	int *next; /* next active point in index order, nPt for none */
+	int *prev; /* previous active point in index order, -1 for none */
+	int first; /* first active point */
+	long long nEval; /* number of distance evaluations for the table */
+	long long nTested; /* number of point pairs tested against the pivots */
+	long long nPruned; /* number of point pairs pruned by the pivots */
+} PivotTable;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void pivot_build(PivotTable *pt, Dat *dat, int nPivot, Arg *arg);
+int pivot_range(PivotTable *pt, int i, float radius, int **cand, int *allocated);
+void pivot_remove(PivotTable *pt, int i);
+void pivot_free(PivotTable *pt);
+
+#endif
+
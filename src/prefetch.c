@@ -0,0 +1,255 @@
+/*==============================================================================
+prefetch.c : speculative epsilon neighbourhoods of likely next points
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The ordering processes one point after the other, but the next point
+	is usually one of the unprocessed neighbours with the lowest RD to
+	the current point. When the neighbourhood of a point is needed, the
+	neighbourhoods of these likely next points are computed with it as a
+	batch, one point per thread. The candidates of all batch points are
+	taken from the search index before the scan, which therefore only
+	reads shared data.
+	A speculative neighbourhood is used if its point is processed while
+	the batch is current; the points processed in the meantime are then
+	removed from it. Points are never unflagged during ordering and
+	candidates are in increasing index order, so the result is the
+	neighbourhood that the point would have had without prefetching.
+	The neighbourhoods of a batch are discarded when the next batch
+	starts, which bounds memory to one batch. */
+
+#include "prefetch.h"
+
+extern int silent;
+
+/*____________________________________________________________________________*/
+/** set up prefetching of 'size' likely next points; cached
+	neighbourhoods need no search and distributed data are searched
+	by all ranks, neither is prefetched */
+void prefetch_init(Prefetch *prefetch, int size, int nPt, NbIndex *nbindex)
+{
+	int i, s;
+
+	prefetch->size = ((nbindex->type == INDEX_CACHE) || (nbindex->type == INDEX_SLICE)) ? 0 : size;
+	prefetch->nSlot = 0;
+	prefetch->nGuess = 0;
+	prefetch->nSpec = 0;
+	prefetch->nUsed = 0;
+	prefetch->slot = 0;
+	if (prefetch->size == 0)
+		return;
+
+	prefetch->slot = safe_malloc(nPt * sizeof(int));
+	for (i = 0; i < nPt; ++ i)
+		prefetch->slot[i] = -1;
+
+	prefetch->point = safe_malloc((prefetch->size + 1) * sizeof(int));
+	prefetch->nCand = safe_malloc((prefetch->size + 1) * sizeof(int));
+	prefetch->cand = safe_malloc((prefetch->size + 1) * sizeof(int *));
+	prefetch->allocatedCand = safe_malloc((prefetch->size + 1) * sizeof(int));
+	prefetch->neigh = safe_malloc((prefetch->size + 1) * sizeof(Epsn *));
+	prefetch->nNeigh = safe_malloc((prefetch->size + 1) * sizeof(int));
+	prefetch->allocatedNeigh = safe_malloc((prefetch->size + 1) * sizeof(int));
+	for (s = 0; s <= prefetch->size; ++ s) {
+		prefetch->allocatedCand[s] = 64;
+		prefetch->cand[s] = safe_malloc(prefetch->allocatedCand[s] * sizeof(int));
+		prefetch->allocatedNeigh[s] = 64;
+		prefetch->neigh[s] = safe_malloc(prefetch->allocatedNeigh[s] * sizeof(Epsn));
+	}
+	prefetch->guess = safe_malloc(prefetch->size * sizeof(int));
+	prefetch->guessRD = safe_malloc(prefetch->size * sizeof(float));
+	prefetch->guessDist = safe_malloc(prefetch->size * sizeof(float));
+}
+
+/*____________________________________________________________________________*/
+/** epsilon neighbours of the point in slot s among its candidates;
+	only slot s is written */
+static void scan_slot(Prefetch *prefetch, int s, Dat *dat, Par *par, OpticsDat *opticsdat, int brute, Arg *arg)
+{
+	int c, j;
+	int i = prefetch->point[s];
+	float dist;
+
+	for (c = 0, prefetch->nNeigh[s] = 0; c < prefetch->nCand[s]; ++ c) {
+		j = brute ? c : prefetch->cand[s][c];
+		if ((j == i) || (opticsdat->pt[j].processed > 0)) continue;
+
+		if ((dist = calc_dist(dat, i, j, arg)) <= par->eps) {
+			prefetch->neigh[s][prefetch->nNeigh[s]].index = j;
+			prefetch->neigh[s][prefetch->nNeigh[s]].dist = dist;
+			/* allocate more space to neighbour array if needed */
+			if (++ prefetch->nNeigh[s] == prefetch->allocatedNeigh[s]) {
+				prefetch->allocatedNeigh[s] += 64;
+				prefetch->neigh[s] = safe_realloc(prefetch->neigh[s], prefetch->allocatedNeigh[s] * sizeof(Epsn));
+			}
+		}
+	}
+}
+
+/*____________________________________________________________________________*/
+/** start a batch with point i and the likely next points;
+	returns the number of batch points */
+static int start_batch(Prefetch *prefetch, Dat *dat, Par *par, OpticsDat *opticsdat, int i, NbIndex *nbindex, Arg *arg)
+{
+	int g, s;
+	int brute = (nbindex->type == INDEX_BRUTE);
+
+	/* discard the unused neighbourhoods of the previous batch */
+	for (s = 0; s < prefetch->nSlot; ++ s)
+		prefetch->slot[prefetch->point[s]] = -1;
+
+	prefetch->point[0] = i;
+	prefetch->nSlot = 1;
+	for (g = 0; g < prefetch->nGuess; ++ g)
+		if ((prefetch->guess[g] != i) && (opticsdat->pt[prefetch->guess[g]].processed == 0))
+			prefetch->point[prefetch->nSlot ++] = prefetch->guess[g];
+	prefetch->nGuess = 0;
+
+	if (prefetch->nSlot == 1) {
+		prefetch->nSlot = 0;
+		return 1;
+	}
+
+	/* candidates from the search index, which is not thread-safe */
+	for (s = 0; s < prefetch->nSlot; ++ s) {
+		prefetch->slot[prefetch->point[s]] = s;
+		prefetch->nCand[s] = neighbour_candidates(nbindex, dat, par, prefetch->point[s], arg);
+		if (brute)
+			continue;
+		if (prefetch->nCand[s] >= prefetch->allocatedCand[s]) {
+			prefetch->allocatedCand[s] = prefetch->nCand[s] + 64;
+			prefetch->cand[s] = safe_realloc(prefetch->cand[s], prefetch->allocatedCand[s] * sizeof(int));
+		}
+		memcpy(prefetch->cand[s], nbindex->cand, prefetch->nCand[s] * sizeof(int));
+	}
+	prefetch->nSpec += prefetch->nSlot - 1;
+
+	/* one batch point per thread */
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for (s = 0; s < prefetch->nSlot; ++ s)
+		scan_slot(prefetch, s, dat, par, opticsdat, brute, arg);
+
+	return prefetch->nSlot;
+}
+
+/*____________________________________________________________________________*/
+/** epsilon neighbourhood of point i from the current batch or a new one;
+	returns 0 if prefetching does not apply and the caller searches */
+int prefetch_neighbourhood(Prefetch *prefetch, Dat *dat, Par *par, OpticsDat *opticsdat, int i, NbIndex *nbindex, Arg *arg)
+{
+	int c, s;
+
+	if (prefetch->size == 0)
+		return 0;
+
+	if ((s = prefetch->slot[i]) < 0) {
+		if (start_batch(prefetch, dat, par, opticsdat, i, nbindex, arg) == 1)
+			return 0;
+		s = 0;
+	} else {
+		++ prefetch->nUsed;
+	}
+	prefetch->slot[i] = -1;
+
+	/* remove the points processed since the batch started */
+	opticsdat->pt[i].epsNeigh = safe_malloc((prefetch->nNeigh[s] + 1) * sizeof(Epsn));
+	for (c = 0, opticsdat->pt[i].nEpsNeigh = 0; c < prefetch->nNeigh[s]; ++ c) {
+		if (opticsdat->pt[prefetch->neigh[s][c].index].processed > 0) continue;
+		opticsdat->pt[i].epsNeigh[opticsdat->pt[i].nEpsNeigh ++] = prefetch->neigh[s][c];
+	}
+
+	if (! silent)
+		fprintf(stderr, "point %d has %d neighbours within %5.2e\n",
+			i, opticsdat->pt[i].nEpsNeigh, par->eps);
+
+	return 1;
+}
+
+/*____________________________________________________________________________*/
+/** guess a before b: lower RD, among equal RDs the more distant point,
+	as in the choice of the next point by cd_rd() */
+__inline__ static int before_guess(float rdA, float distA, float rdB, float distB)
+{
+	return ((rdA < rdB) || ((rdA == rdB) && (distA > distB)));
+}
+
+/*____________________________________________________________________________*/
+/** record the likely points after point 'next': the neighbours of the
+	current point i with the lowest RD, as already updated by point i;
+	ranking them by their RD after 'next' has been processed would take
+	a distance to 'next' per neighbour on the calling thread */
+void prefetch_guess(Prefetch *prefetch, Par *par, OpticsDat *opticsdat, int i, int next)
+{
+	int c, g, k;
+	float rd, dist;
+
+	prefetch->nGuess = 0;
+	if ((prefetch->size == 0) || (next < 0))
+		return;
+
+	/* insertion into the short list of lowest RDs */
+	for (c = 0; c < opticsdat->pt[i].nEpsNeigh; ++ c) {
+		k = opticsdat->pt[i].epsNeigh[c].index;
+		if ((k == next) || (opticsdat->pt[k].processed > 0)) continue;
+		/* points without core distance need no neighbourhood */
+		if ((opticsdat->core != 0) && (! opticsdat->core[k])) continue;
+
+		rd = opticsdat->pt[k].reachDist;
+		dist = opticsdat->pt[i].epsNeigh[c].dist;
+
+		if ((prefetch->nGuess == prefetch->size) &&
+			! before_guess(rd, dist, prefetch->guessRD[prefetch->nGuess - 1], prefetch->guessDist[prefetch->nGuess - 1]))
+			continue;
+		if (prefetch->nGuess < prefetch->size)
+			++ prefetch->nGuess;
+		for (g = prefetch->nGuess - 1; (g > 0) &&
+			before_guess(rd, dist, prefetch->guessRD[g - 1], prefetch->guessDist[g - 1]); -- g) {
+			prefetch->guess[g] = prefetch->guess[g - 1];
+			prefetch->guessRD[g] = prefetch->guessRD[g - 1];
+			prefetch->guessDist[g] = prefetch->guessDist[g - 1];
+		}
+		prefetch->guess[g] = k;
+		prefetch->guessRD[g] = rd;
+		prefetch->guessDist[g] = dist;
+	}
+}
+
+/*____________________________________________________________________________*/
+/** report the use of speculative neighbourhoods */
+void prefetch_report(Prefetch *prefetch)
+{
+	if (silent || (prefetch->nSpec == 0))
+		return;
+
+	fprintf(stderr, "%lld of %lld prefetched neighbourhoods used (%.1f%%)\n",
+		prefetch->nUsed, prefetch->nSpec, 100. * prefetch->nUsed / prefetch->nSpec);
+}
+
+/*____________________________________________________________________________*/
+/** free prefetch memory */
+void prefetch_free(Prefetch *prefetch)
+{
+	int s;
+
+	if (prefetch->size == 0)
+		return;
+
+	for (s = 0; s <= prefetch->size; ++ s) {
+		free(prefetch->cand[s]);
+		free(prefetch->neigh[s]);
+	}
+	free(prefetch->slot);
+	free(prefetch->point);
+	free(prefetch->nCand);
+	free(prefetch->cand);
+	free(prefetch->allocatedCand);
+	free(prefetch->neigh);
+	free(prefetch->nNeigh);
+	free(prefetch->allocatedNeigh);
+	free(prefetch->guess);
+	free(prefetch->guessRD);
+	free(prefetch->guessDist);
+}
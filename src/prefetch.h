@@ -0,0 +1,44 @@
+/*==============================================================================
+prefetch.h : speculative epsilon neighbourhoods of likely next points
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include "neighbour.h"
+#include "optics.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* batch of neighbourhoods: the current point and its likely successors */
+typedef struct {
+	int size; /* number of likely next points per batch, 0: off */
+	int *slot; /* batch slot of each point, -1 if none */
+	int nSlot; /* number of slots in the current batch */
+	int *point; /* point of each slot */
+	int *nCand; /* number of candidate neighbours of each slot */
+	int **cand; /* candidate neighbours of each slot */
+	int *allocatedCand; /* allocated size of each candidate array */
+	Epsn **neigh; /* epsilon neighbours of each slot */
+	int *nNeigh; /* number of epsilon neighbours of each slot */
+	int *allocatedNeigh; /* allocated size of each neighbour array */
+	int *guess; /* likely next points, most likely first */
+	float *guessRD; /* RD of the likely next points */
+	float *guessDist; /* distance of the likely next points to the current point */
+	int nGuess; /* number of likely next points */
+	long long nSpec; /* number of speculative neighbourhoods */
+	long long nUsed; /* number of speculative neighbourhoods used */
+} Prefetch;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void prefetch_init(Prefetch *prefetch, int size, int nPt, NbIndex *nbindex);
+int prefetch_neighbourhood(Prefetch *prefetch, Dat *dat, Par *par, OpticsDat *opticsdat, int i, NbIndex *nbindex, Arg *arg);
+void prefetch_guess(Prefetch *prefetch, Par *par, OpticsDat *opticsdat, int i, int next);
+void prefetch_report(Prefetch *prefetch);
+void prefetch_free(Prefetch *prefetch);
+
+#endif
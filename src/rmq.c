@@ -0,0 +1,82 @@
+/*==============================================================================
+rmq.c : range maximum/minimum queries on a sparse table
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The table is built in O(n log n) and answers a query in O(1) from two
+	overlapping power-of-two ranges. Of equal values the lowest position
+	is returned, as a stable sort would put it first. */
+
+#include "rmq.h"
+
+/*____________________________________________________________________________*/
+/** extreme value first, equal values by lower position */
+__inline__ static int before(Rmq *rmq, int a, int b)
+{
+	if (rmq->max)
+		return ((rmq->value[a] > rmq->value[b]) ||
+				((rmq->value[a] == rmq->value[b]) && (a < b)));
+	else
+		return ((rmq->value[a] < rmq->value[b]) ||
+				((rmq->value[a] == rmq->value[b]) && (a < b)));
+}
+
+/*____________________________________________________________________________*/
+/** build sparse table over 'n' values; 'max' selects maximum queries */
+void rmq_init(Rmq *rmq, float *value, int n, int max)
+{
+	int i, k, h;
+
+	rmq->n = n;
+	rmq->max = max;
+	rmq->value = value;
+
+	/* at least entries 0 and 1, also for n = 0 */
+	rmq->log2 = safe_malloc((n + 2) * sizeof(int));
+	rmq->log2[0] = 0;
+	rmq->log2[1] = 0;
+	for (i = 2; i <= n; ++ i)
+		rmq->log2[i] = rmq->log2[i / 2] + 1;
+	rmq->nLevel = rmq->log2[n] + 1;
+
+	rmq->table = safe_malloc(rmq->nLevel * sizeof(int *));
+	rmq->table[0] = safe_malloc(n * sizeof(int));
+	for (i = 0; i < n; ++ i)
+		rmq->table[0][i] = i;
+
+	for (k = 1, h = 1; k < rmq->nLevel; ++ k, h *= 2) {
+		rmq->table[k] = safe_malloc((n - 2 * h + 1) * sizeof(int));
+		for (i = 0; i + 2 * h <= n; ++ i)
+			rmq->table[k][i] = before(rmq, rmq->table[k - 1][i + h], rmq->table[k - 1][i]) ?
+								rmq->table[k - 1][i + h] : rmq->table[k - 1][i];
+	}
+}
+
+/*____________________________________________________________________________*/
+/** position of the extreme value in [first, last] */
+int rmq_query(Rmq *rmq, int first, int last)
+{
+	int k, a, b;
+
+	assert((first >= 0) && (first <= last) && (last < rmq->n));
+
+	k = rmq->log2[last - first + 1];
+	a = rmq->table[k][first];
+	b = rmq->table[k][last - (1 << k) + 1];
+
+	return (before(rmq, b, a) ? b : a);
+}
+
+/*____________________________________________________________________________*/
+/** free sparse table */
+void rmq_free(Rmq *rmq)
+{
+	int k;
+
+	for (k = 0; k < rmq->nLevel; ++ k)
+		free(rmq->table[k]);
+	free(rmq->table);
+	free(rmq->log2);
+}
+
@@ -0,0 +1,35 @@
+/*==============================================================================
+rmq.h : range maximum/minimum queries on a sparse table
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef RMQ_H
+#define RMQ_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "safe.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* sparse table: position of the extreme value in every range of length 2^k */
+typedef struct {
+	int n; /* number of values */
+	int nLevel; /* number of levels k */
+	int max; /* 1: range maximum, 0: range minimum */
+	float *value; /* values (not owned) */
+	int **table; /* table[k][i]: extreme position in [i, i + 2^k - 1] */
+	int *log2; /* floor(log2(length)) for each range length */
+} Rmq;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void rmq_init(Rmq *rmq, float *value, int n, int max);
+int rmq_query(Rmq *rmq, int first, int last);
+void rmq_free(Rmq *rmq);
+
+#endif
+
@@ -0,0 +1,120 @@
+/*==============================================================================
+seedlist.c : indexed priority queue of points ordered by reachability distance
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#include "seedlist.h"
+
+/*____________________________________________________________________________*/
+/** heap order: lower key first, equal keys by lower point index */
+__inline__ static int before(SeedList *seeds, int a, int b)
+{
+	return ((seeds->key[a] < seeds->key[b]) ||
+			((seeds->key[a] == seeds->key[b]) && (a < b)));
+}
+
+/*____________________________________________________________________________*/
+/** place point k at heap position h */
+__inline__ static void place(SeedList *seeds, int h, int k)
+{
+	seeds->heap[h] = k;
+	seeds->pos[k] = h;
+}
+
+/*____________________________________________________________________________*/
+/** move heap entry at position h towards the root */
+static void sift_up(SeedList *seeds, int h)
+{
+	int k = seeds->heap[h];
+	int p;
+
+	while ((h > 0) && before(seeds, k, seeds->heap[p = (h - 1) / 2])) {
+		place(seeds, h, seeds->heap[p]);
+		h = p;
+	}
+	place(seeds, h, k);
+}
+
+/*____________________________________________________________________________*/
+/** move heap entry at position h towards the leaves */
+static void sift_down(SeedList *seeds, int h)
+{
+	int k = seeds->heap[h];
+	int c;
+
+	while ((c = 2 * h + 1) < seeds->nSeed) {
+		if ((c + 1 < seeds->nSeed) && before(seeds, seeds->heap[c + 1], seeds->heap[c]))
+			++ c;
+		if (! before(seeds, seeds->heap[c], k))
+			break;
+		place(seeds, h, seeds->heap[c]);
+		h = c;
+	}
+	place(seeds, h, k);
+}
+
+/*____________________________________________________________________________*/
+/** initialise empty seed list for 'nPt' points */
+void seedlist_init(SeedList *seeds, int nPt)
+{
+	int i;
+
+	seeds->nPt = nPt;
+	seeds->nSeed = 0;
+	seeds->heap = safe_malloc(nPt * sizeof(int));
+	seeds->pos = safe_malloc(nPt * sizeof(int));
+	seeds->key = safe_malloc(nPt * sizeof(float));
+
+	for (i = 0; i < nPt; ++ i)
+		seeds->pos[i] = -1;
+}
+
+/*____________________________________________________________________________*/
+/** insert point k with reachability distance 'key',
+	or lower its key if it is already in the list */
+void seedlist_update(SeedList *seeds, int k, float key)
+{
+	if (seeds->pos[k] < 0) {
+		seeds->key[k] = key;
+		seeds->pos[k] = seeds->nSeed ++;
+		seeds->heap[seeds->pos[k]] = k;
+	} else if (key < seeds->key[k]) {
+		seeds->key[k] = key;
+	} else {
+		return;
+	}
+
+	sift_up(seeds, seeds->pos[k]);
+}
+
+/*____________________________________________________________________________*/
+/** remove and return the point with the lowest reachability distance;
+	returns -1 if the list is empty */
+int seedlist_pop(SeedList *seeds)
+{
+	int k;
+
+	if (seeds->nSeed == 0)
+		return -1;
+
+	k = seeds->heap[0];
+	seeds->pos[k] = -1;
+
+	if (-- seeds->nSeed > 0) {
+		place(seeds, 0, seeds->heap[seeds->nSeed]);
+		sift_down(seeds, 0);
+	}
+
+	return k;
+}
+
+/*____________________________________________________________________________*/
+/** free seed list memory */
+void seedlist_free(SeedList *seeds)
+{
+	free(seeds->heap);
+	free(seeds->pos);
+	free(seeds->key);
+}
+
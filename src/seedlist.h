@@ -0,0 +1,35 @@
+/*==============================================================================
+seedlist.h : indexed priority queue of points ordered by reachability distance
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef SEEDLIST_H
+#define SEEDLIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "safe.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* seed list: binary min-heap with position index for decrease-key */
+typedef struct {
+	int nPt; /* number of points */
+	int nSeed; /* number of points in the heap */
+	int *heap; /* heap of point indices */
+	int *pos; /* heap position of each point, -1 if not in the heap */
+	float *key; /* reachability distance of each point in the heap */
+} SeedList;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void seedlist_init(SeedList *seeds, int nPt);
+void seedlist_update(SeedList *seeds, int k, float key);
+int seedlist_pop(SeedList *seeds);
+void seedlist_free(SeedList *seeds);
+
+#endif
+
@@ -0,0 +1,232 @@
+/*==============================================================================
+slice.c : data points distributed over MPI ranks
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* Rank 0 reads the data, orders the points and writes the output files.
+	Each rank, including rank 0, owns a contiguous slice of the data points
+	with its own search index. The epsilon neighbourhood of the current
+	point is a collective range query: rank 0 broadcasts the point, every
+	rank scans its unprocessed points and rank 0 gathers the neighbours in
+	rank order. Slices are in index order, so the neighbour list equals
+	that of the serial search. The query point is processed from then on;
+	every processed point is a query point, so the processed flags of the
+	slices follow those of rank 0 without further messages. */
+
+#include "slice.h"
+
+extern int silent;
+
+#if defined MPI && defined DATAXYZ
+
+/*____________________________________________________________________________*/
+/** range query of point i (data index) at 'query': epsilon neighbours
+	(data indices) among the unprocessed points of this rank; the query
+	point is stored after the slice points */
+static void local_neighbourhood(Slice *slice, Par *par, int i, float *query, Arg *arg)
+{
+	int c, j, nCand;
+	float dist;
+
+	/* the query point is processed and no neighbour candidate anymore */
+	if ((i >= slice->first) && (i < slice->first + slice->nPt)) {
+		slice->processed[i - slice->first] = 1;
+		neighbour_remove(&(slice->nbindex), i - slice->first);
+	}
+
+	slice->dat.x[slice->nPt] = query[0];
+	slice->dat.y[slice->nPt] = query[1];
+	slice->dat.z[slice->nPt] = query[2];
+	nCand = neighbour_candidates_at(&(slice->nbindex), &(slice->dat), par, query);
+
+	for (c = 0, slice->nNeigh = 0; c < nCand; ++ c) {
+		j = (slice->nbindex.type == INDEX_BRUTE) ? c : slice->nbindex.cand[c];
+		if (slice->processed[j]) continue;
+
+		/* query point first, as in the serial search */
+		if ((dist = calc_dist(&(slice->dat), slice->nPt, j, arg)) <= par->eps) {
+			slice->neigh[slice->nNeigh].index = slice->first + j;
+			slice->neigh[slice->nNeigh].dist = dist;
+			/* allocate more space to neighbour array if needed */
+			if (++ slice->nNeigh == slice->allocated) {
+				slice->allocated += 64;
+				slice->neigh = safe_realloc(slice->neigh, slice->allocated * sizeof(Epsn));
+			}
+		}
+	}
+}
+
+/*____________________________________________________________________________*/
+/** distribute the data points (read by rank 0 into 'dat', unused on
+	other ranks) over all ranks and build the search index of each slice;
+	collective */
+void slice_init(Slice *slice, Dat *dat, Par *par, Arg *arg)
+{
+	int r;
+	int *count = 0;
+	int *displ = 0;
+	int blockLength[2] = {1, 1};
+	MPI_Aint offset[2] = {offsetof(Epsn, index), offsetof(Epsn, dist)};
+	MPI_Datatype type[2] = {MPI_INT, MPI_FLOAT};
+	Arg sliceArg = *arg;
+
+	MPI_Comm_rank(MPI_COMM_WORLD, &(slice->rank));
+	MPI_Comm_size(MPI_COMM_WORLD, &(slice->nRank));
+
+	if (slice->rank == 0)
+		slice->nData = dat->nData;
+	MPI_Bcast(&(slice->nData), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	/* contiguous slices of (nearly) equal size */
+	slice->firstOf = safe_malloc((slice->nRank + 1) * sizeof(int));
+	slice->nPtOf = safe_malloc(slice->nRank * sizeof(int));
+	count = safe_malloc(slice->nRank * sizeof(int));
+	displ = safe_malloc(slice->nRank * sizeof(int));
+	for (r = 0; r <= slice->nRank; ++ r)
+		slice->firstOf[r] = (int)(((long long)slice->nData * r) / slice->nRank);
+	for (r = 0; r < slice->nRank; ++ r) {
+		slice->nPtOf[r] = slice->firstOf[r + 1] - slice->firstOf[r];
+		count[r] = slice->nPtOf[r];
+		displ[r] = slice->firstOf[r];
+	}
+	slice->first = slice->firstOf[slice->rank];
+	slice->nPt = slice->nPtOf[slice->rank];
+
+	/* slice points and one more for the query point */
+	alloc_xyz(&(slice->dat), slice->nPt + 1);
+	slice->dat.nData = slice->nPt;
+	MPI_Scatterv((slice->rank == 0) ? dat->x : 0, count, displ, MPI_FLOAT,
+		slice->dat.x, slice->nPt, MPI_FLOAT, 0, MPI_COMM_WORLD);
+	MPI_Scatterv((slice->rank == 0) ? dat->y : 0, count, displ, MPI_FLOAT,
+		slice->dat.y, slice->nPt, MPI_FLOAT, 0, MPI_COMM_WORLD);
+	MPI_Scatterv((slice->rank == 0) ? dat->z : 0, count, displ, MPI_FLOAT,
+		slice->dat.z, slice->nPt, MPI_FLOAT, 0, MPI_COMM_WORLD);
+	free(count);
+	free(displ);
+
+	slice->processed = safe_malloc((slice->nPt + 1) * sizeof(char));
+	for (r = 0; r < slice->nPt; ++ r)
+		slice->processed[r] = 0;
+
+	/* the spatial indices answer queries by coordinates */
+	if ((sliceArg.nbIndex != INDEX_KDTREE) && (sliceArg.nbIndex != INDEX_GRID)) {
+		if ((sliceArg.nbIndex != INDEX_BRUTE) && (slice->rank == 0))
+			fprintf(stderr, "Distributed data: using brute-force neighbour search\n");
+		sliceArg.nbIndex = INDEX_BRUTE;
+	}
+	if (slice->nPt < 2)
+		sliceArg.nbIndex = INDEX_BRUTE;
+	neighbour_init(&(slice->nbindex), &(slice->dat), par, &sliceArg);
+
+	slice->allocated = 64;
+	slice->neigh = safe_malloc(slice->allocated * sizeof(Epsn));
+	slice->nNeigh = 0;
+	slice->nNeighOf = safe_malloc(slice->nRank * sizeof(int));
+	slice->offsetOf = safe_malloc(slice->nRank * sizeof(int));
+
+	MPI_Type_create_struct(2, blockLength, offset, type, &(slice->epsnType));
+	MPI_Type_commit(&(slice->epsnType));
+
+	if ((slice->rank == 0) && (! silent))
+		fprintf(stderr, "%d points on %d ranks\n", slice->nData, slice->nRank);
+}
+
+/*____________________________________________________________________________*/
+/** set up 'nbindex' as the distributed search over all ranks (rank 0) */
+void slice_search(Slice *slice, NbIndex *nbindex)
+{
+	nbindex->type = INDEX_SLICE;
+	nbindex->nPt = slice->nData;
+	nbindex->cand = 0;
+	nbindex->allocated = 0;
+	nbindex->list = 0;
+	nbindex->nList = 0;
+	nbindex->nEval = 0;
+	nbindex->nEvalBrute = 0;
+	nbindex->nRemoved = 0;
+	nbindex->slice = slice;
+}
+
+/*____________________________________________________________________________*/
+/** epsilon neighbourhood of point i from all ranks (rank 0) */
+void slice_neighbourhood(Slice *slice, Par *par, OpticsDat *opticsdat, Dat *dat, int i, Arg *arg)
+{
+	int r, nEpsNeigh;
+	float query[3] = {dat->x[i], dat->y[i], dat->z[i]};
+
+	MPI_Bcast(&i, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Bcast(query, 3, MPI_FLOAT, 0, MPI_COMM_WORLD);
+
+	local_neighbourhood(slice, par, i, query, arg);
+
+	/* neighbours of all ranks in rank order */
+	MPI_Gather(&(slice->nNeigh), 1, MPI_INT, slice->nNeighOf, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	for (r = 0, nEpsNeigh = 0; r < slice->nRank; ++ r) {
+		slice->offsetOf[r] = nEpsNeigh;
+		nEpsNeigh += slice->nNeighOf[r];
+	}
+	opticsdat->pt[i].epsNeigh = safe_realloc(opticsdat->pt[i].epsNeigh, (nEpsNeigh + 1) * sizeof(Epsn));
+	MPI_Gatherv(slice->neigh, slice->nNeigh, slice->epsnType,
+		opticsdat->pt[i].epsNeigh, slice->nNeighOf, slice->offsetOf, slice->epsnType, 0, MPI_COMM_WORLD);
+	opticsdat->pt[i].nEpsNeigh = nEpsNeigh;
+}
+
+/*____________________________________________________________________________*/
+/** answer range queries until rank 0 stops (ranks other than 0) */
+void slice_serve(Slice *slice, Par *par, Arg *arg)
+{
+	int i;
+	float query[3];
+
+	while (1) {
+		MPI_Bcast(&i, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		if (i < 0)
+			break;
+		MPI_Bcast(query, 3, MPI_FLOAT, 0, MPI_COMM_WORLD);
+
+		local_neighbourhood(slice, par, i, query, arg);
+
+		MPI_Gather(&(slice->nNeigh), 1, MPI_INT, 0, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		MPI_Gatherv(slice->neigh, slice->nNeigh, slice->epsnType,
+			0, 0, 0, slice->epsnType, 0, MPI_COMM_WORLD);
+	}
+
+	slice_stop(slice);
+}
+
+/*____________________________________________________________________________*/
+/** end the range queries and report distance evaluations; collective,
+	called by rank 0 after the ordering and by slice_serve() */
+void slice_stop(Slice *slice)
+{
+	int i = -1;
+	long long nEval[2] = {slice->nbindex.nEval, slice->nbindex.nEvalBrute};
+	long long nEvalSum[2] = {0, 0};
+
+	if (slice->rank == 0)
+		MPI_Bcast(&i, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+	MPI_Reduce(nEval, nEvalSum, 2, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+	if ((slice->rank == 0) && (! silent) && (nEvalSum[1] > 0))
+		fprintf(stderr, "%lld distance evaluations in neighbour search on %d ranks (%.1f%% of brute force)\n",
+			nEvalSum[0], slice->nRank, 100. * nEvalSum[0] / nEvalSum[1]);
+}
+
+/*____________________________________________________________________________*/
+/** free slice memory */
+void slice_free(Slice *slice)
+{
+	neighbour_free(&(slice->nbindex));
+	MPI_Type_free(&(slice->epsnType));
+	free_xyz(&(slice->dat));
+	free(slice->processed);
+	free(slice->neigh);
+	free(slice->nNeighOf);
+	free(slice->offsetOf);
+	free(slice->firstOf);
+	free(slice->nPtOf);
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*==============================================================================
+slice.h : data points distributed over MPI ranks
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef SLICE_H
+#define SLICE_H
+
+#include "neighbour.h"
+#include "optics.h"
+
+/* distributed data: 'configure --enable-data-xyz --enable-mpi' */
+#if defined MPI && defined DATAXYZ
+#include <mpi.h>
+#include <stddef.h>
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* contiguous slice of the data points owned by one rank */
+struct Slice {
+	int rank; /* rank of this process */
+	int nRank; /* number of ranks */
+	int nData; /* number of data points of all ranks */
+	int first; /* data index of the first point of this rank */
+	int nPt; /* number of points of this rank */
+	int *firstOf; /* first data index of each rank */
+	int *nPtOf; /* number of points of each rank */
+	Dat dat; /* points of this rank, followed by the query point */
+	char *processed; /* processed flag of each point of this rank */
+	NbIndex nbindex; /* search index over the points of this rank */
+	Epsn *neigh; /* epsilon neighbours of the query point on this rank */
+	int nNeigh; /* number of epsilon neighbours on this rank */
+	int allocated; /* allocated size of neighbour array */
+	int *nNeighOf; /* number of epsilon neighbours on each rank */
+	int *offsetOf; /* position of the neighbours of each rank in the list */
+	MPI_Datatype epsnType; /* MPI type of Epsn */
+};
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void slice_init(Slice *slice, Dat *dat, Par *par, Arg *arg);
+void slice_search(Slice *slice, NbIndex *nbindex);
+void slice_neighbourhood(Slice *slice, Par *par, OpticsDat *opticsdat, Dat *dat, int i, Arg *arg);
+void slice_serve(Slice *slice, Par *par, Arg *arg);
+void slice_stop(Slice *slice);
+void slice_free(Slice *slice);
+
+#endif
+
+#endif
@@ -4,17 +4,122 @@ sort.h : sort alogorithms implementation
 Read the COPYING file for license information.
 ================================================================================*/
 
-#ifndef SORT_H 
-#define SORT_H 
+#ifndef SORT_H
+#define SORT_H
 
 #include <stdio.h>
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "safe.h"
 
 /*____________________________________________________________________________*/
-/* prototypes */
-void MergeSort(void *array, size_t size, size_t esize, int (*compare) (const void *key1, const void *key2));
+/* typed stable merge sort */
+/* MERGESORT_DEFINE(name, type, before) defines
+	'static void name(type *array, int n)', a stable sort of 'n' values of
+	'type' into the order given by 'before(a, b)', which is true if value a
+	strictly precedes value b. Equal values keep their input order.
+	Runs of up to MERGESORT_RUN values are sorted by insertion; the merges
+	alternate between the array and a scratch copy, so that every merge
+	writes its result once. Scratch space is on the stack for up to
+	MERGESORT_STACK values. With OpenMP, the halves of ranges of more than
+	MERGESORT_TASK values are sorted as parallel tasks; the result does
+	not depend on the number of threads. */
+#define MERGESORT_RUN 24
+#define MERGESORT_STACK 256
+#define MERGESORT_TASK 16384
+
+#ifdef _OPENMP
+#define MERGESORT_PRAGMA(x) _Pragma(x)
+#define MERGESORT_PARALLEL(n) (((n) > MERGESORT_TASK) && (omp_get_max_threads() > 1) && (! omp_in_parallel()))
+#else
+#define MERGESORT_PRAGMA(x)
+#define MERGESORT_PARALLEL(n) 0
+#endif
+
+#define MERGESORT_DEFINE(name, type, before) \
+\
+/* insertion sort of a[left,right) */ \
+static void name##_insert(type *a, int left, int right) \
+{ \
+	int i, j; \
+	type t; \
+\
+	for (i = left + 1; i < right; ++ i) { \
+		t = a[i]; \
+		for (j = i; (j > left) && before(t, a[j - 1]); -- j) \
+			a[j] = a[j - 1]; \
+		a[j] = t; \
+	} \
+} \
+\
+/* merge src[left,mid) and src[mid,right) into dst[left,right); \
+	the left value goes first unless the right one precedes it */ \
+static void name##_merge(type *src, int left, int mid, int right, type *dst) \
+{ \
+	int l = left; \
+	int r = mid; \
+	int k = left; \
+\
+	while ((l < mid) && (r < right)) \
+		dst[k ++] = before(src[r], src[l]) ? src[r ++] : src[l ++]; \
+	if (l < mid) \
+		memcpy(&(dst[k]), &(src[l]), (mid - l) * sizeof(type)); \
+	else if (r < right) \
+		memcpy(&(dst[k]), &(src[r]), (right - r) * sizeof(type)); \
+} \
+\
+/* sort dst[left,right) from src[left,right); both hold the same values */ \
+static void name##_split(type *src, int left, int right, type *dst) \
+{ \
+	int mid = left + (right - left) / 2; \
+\
+	if (right - left <= MERGESORT_RUN) { \
+		name##_insert(dst, left, right); \
+		return; \
+	} \
+\
+	/* sort both halves into src, then merge them into dst */ \
+	if (right - left > MERGESORT_TASK) { \
+		MERGESORT_PRAGMA("omp task") \
+		name##_split(dst, left, mid, src); \
+		MERGESORT_PRAGMA("omp task") \
+		name##_split(dst, mid, right, src); \
+		MERGESORT_PRAGMA("omp taskwait") \
+	} else { \
+		name##_split(dst, left, mid, src); \
+		name##_split(dst, mid, right, src); \
+	} \
+	name##_merge(src, left, mid, right, dst); \
+} \
+\
+static void name(type *array, int n) \
+{ \
+	type stack[MERGESORT_STACK]; \
+	type *scratch = stack; \
+\
+	if (n <= MERGESORT_RUN) { \
+		name##_insert(array, 0, n); \
+		return; \
+	} \
+\
+	if (n > MERGESORT_STACK) \
+		scratch = safe_malloc(n * sizeof(type)); \
+	memcpy(scratch, array, n * sizeof(type)); \
+\
+	if (MERGESORT_PARALLEL(n)) { \
+		MERGESORT_PRAGMA("omp parallel") \
+		MERGESORT_PRAGMA("omp single") \
+		name##_split(scratch, 0, n, array); \
+	} else { \
+		name##_split(scratch, 0, n, array); \
+	} \
+\
+	if (scratch != stack) \
+		free(scratch); \
+}
 
 #endif
 
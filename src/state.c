@@ -0,0 +1,258 @@
+/*==============================================================================
+state.c : ordering state for incremental updates
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* The ordering is a sequence of steps: step k processes one point,
+	computes its core distance from the unprocessed points within eps,
+	lowers their reachability distances and selects the next point.
+	A step does not depend on points outside its epsilon neighbourhood,
+	except through the choice of the next point when no neighbour
+	follows. After points are added to or removed from the data set,
+	all steps before the first one that had (or would have had) a changed
+	point in its epsilon neighbourhood are therefore unchanged, and so is
+	the removed point's own step. The ordering resumes at that position;
+	the reachability distances of the unprocessed points are restored from
+	the core distances of the kept steps. The result is identical to an
+	ordering of the updated data set from scratch. */
+
+#include "state.h"
+
+extern int silent;
+
+#define STATE_TITLE "# OPTICS ordering state\n"
+
+/*____________________________________________________________________________*/
+/** max floats */
+__inline__ static float max_float(float a, float b)
+{
+	return ((a > b ) ? a : b);
+}
+
+/*____________________________________________________________________________*/
+/** candidate c of the current neighbour search */
+__inline__ static int candidate(NbIndex *nbindex, int c)
+{
+	return ((nbindex->type == INDEX_BRUTE) ? c : nbindex->cand[c]);
+}
+
+/*____________________________________________________________________________*/
+/** write ordering state; floats are written with 9 significant digits,
+	which restores them exactly */
+void state_write(char *fileName, Pt **ordered_data, int nOrdered, int nPt, Par *par, Arg *arg)
+{
+	int k;
+	char outName[256] = "";
+	FILE *stateFile = 0;
+
+	sprintf(outName, "%s/%s", arg->outPathName, fileName);
+	stateFile = safe_open(outName, "w");
+
+	fprintf(stateFile, STATE_TITLE);
+	fprintf(stateFile, "npoints %d eps %.9g minpts %d order %d nordered %d\n",
+		nPt, par->eps, par->minPts, arg->order, nOrdered);
+	fprintf(stateFile, "    dataId              CD              RD nEpsNeigh\n");
+	for (k = 0; k < nOrdered; ++ k)
+		fprintf(stateFile, "%10d %15.9g %15.9g %9d\n", (*ordered_data[k]).index,
+			(*ordered_data[k]).coreDist, (*ordered_data[k]).reachDist, (*ordered_data[k]).nEpsNeigh);
+
+	fclose(stateFile);
+}
+
+/*____________________________________________________________________________*/
+/** read ordering state of a previous run on the same data,
+	possibly with further points appended */
+void state_read(char *fileName, State *state, Dat *dat, Par *par, Arg *arg)
+{
+	int k;
+	char line[256];
+	char *seen = 0;
+	FILE *stateFile = safe_open(fileName, "r");
+
+	if ((fgets(line, sizeof(line), stateFile) == 0) || (strcmp(line, STATE_TITLE) != 0) ||
+		(fscanf(stateFile, " npoints %d eps %f minpts %d order %d nordered %d",
+			&(state->nPt), &(state->eps), &(state->minPts), &(state->order), &(state->nOrdered)) != 5) ||
+		(fgets(line, sizeof(line), stateFile) == 0) || (fgets(line, sizeof(line), stateFile) == 0)) {
+		fprintf(stderr, "Error: '%s' is no OPTICS state file\n", fileName);
+		exit(1);
+	}
+
+	if ((state->eps != par->eps) || (state->minPts != par->minPts) || (state->order != arg->order)) {
+		fprintf(stderr, "Error: state file '%s' was written with different eps, minpts or order\n", fileName);
+		exit(1);
+	}
+	if ((state->nPt > dat->nData) || (state->nOrdered > state->nPt)) {
+		fprintf(stderr, "Error: state file '%s' has more points than the data file\n", fileName);
+		exit(1);
+	}
+
+	state->index = safe_malloc((state->nOrdered + 1) * sizeof(int));
+	state->coreDist = safe_malloc((state->nOrdered + 1) * sizeof(float));
+	state->reachDist = safe_malloc((state->nOrdered + 1) * sizeof(float));
+	state->nEpsNeigh = safe_malloc((state->nOrdered + 1) * sizeof(int));
+	seen = safe_malloc((state->nPt + 1) * sizeof(char));
+	for (k = 0; k < state->nPt; ++ k)
+		seen[k] = 0;
+
+	for (k = 0; k < state->nOrdered; ++ k) {
+		if ((fscanf(stateFile, "%d %f %f %d", &(state->index[k]), &(state->coreDist[k]),
+				&(state->reachDist[k]), &(state->nEpsNeigh[k])) != 4) ||
+			(state->index[k] < 0) || (state->index[k] >= state->nPt) || seen[state->index[k]]) {
+			fprintf(stderr, "Error: format error in state file '%s' at position %d\n", fileName, k);
+			exit(1);
+		}
+		seen[state->index[k]] = 1;
+	}
+
+	free(seen);
+	fclose(stateFile);
+}
+
+/*____________________________________________________________________________*/
+/** flag the points listed in file 'fileName' (indices as in the data file)
+	as removed; returns the number of listed points */
+int state_removed(char *fileName, char *removed, int nPt)
+{
+	int i, n = 0;
+	FILE *removedFile = safe_open(fileName, "r");
+
+	while (fscanf(removedFile, "%d", &i) == 1) {
+		if ((i < 0) || (i >= nPt)) {
+			fprintf(stderr, "Error: removed point %d is not in the data file\n", i);
+			exit(1);
+		}
+		removed[i] = 1;
+		++ n;
+	}
+	if (! feof(removedFile)) {
+		fprintf(stderr, "Error: format error in file '%s'\n", fileName);
+		exit(1);
+	}
+
+	fclose(removedFile);
+
+	return n;
+}
+
+/*____________________________________________________________________________*/
+/** keep the unchanged steps of the previous ordering: restore them in
+	'opticsdat' and 'ordered_data', remove them from the search index and
+	restore the reachability distances (and seed list) of the remaining
+	points; points of the previous data set missing in its ordering are
+	flagged as removed; 'next' is the point of the first recomputed step
+	if known, otherwise -1; returns the number of restored steps */
+/* All neighbour searches happen before any point leaves the index. */
+int state_resume(State *state, Dat *dat, Par *par, OpticsDat *opticsdat, Pt **ordered_data, char *removed, NbIndex *nbindex, SeedList *seeds, Arg *arg, int *next)
+{
+	int c, i, j, k, nCand, limit, reached;
+	int nNew = 0, nRemoved = 0;
+	int resume = state->nOrdered; /* first recomputed step */
+	int *position = safe_malloc(dat->nData * sizeof(int));
+	float dist;
+
+	/* position of each point in the previous ordering, -1 if none */
+	for (i = 0; i < dat->nData; ++ i)
+		position[i] = -1;
+	for (k = 0; k < state->nOrdered; ++ k)
+		position[state->index[k]] = k;
+
+	for (i = 0; i < dat->nData; ++ i) {
+		if (i < state->nPt) {
+			/* removed in an earlier update */
+			if (position[i] < 0) {
+				removed[i] = 1;
+				continue;
+			}
+			/* unchanged point */
+			if (! removed[i])
+				continue;
+			/* removed point: its own step and the steps before it */
+			++ nRemoved;
+			limit = position[i];
+		} else {
+			/* new point: any step */
+			if (removed[i])
+				continue;
+			++ nNew;
+			limit = state->nOrdered;
+		}
+
+		if (limit < resume)
+			resume = limit;
+		if (resume == 0)
+			continue;
+
+		/* earliest step that has point i in its epsilon neighbourhood */
+		nCand = neighbour_candidates(nbindex, dat, par, i, arg);
+		for (c = 0; c < nCand; ++ c) {
+			j = candidate(nbindex, c);
+			k = position[j];
+			if ((k < 0) || (k >= limit) || (k >= resume))
+				continue;
+			if (calc_dist(dat, j, i, arg) <= par->eps)
+				resume = k;
+		}
+	}
+
+	/* the first recomputed step processes the same point
+		unless that point has been removed */
+	*next = ((resume < state->nOrdered) && (! removed[state->index[resume]])) ?
+				state->index[resume] : -1;
+
+	/* reachability distances of the remaining points
+		from the core points of the kept steps */
+	for (i = 0; (resume > 0) && (i < dat->nData); ++ i) {
+		if (removed[i] || ((position[i] >= 0) && (position[i] < resume)))
+			continue;
+
+		nCand = neighbour_candidates(nbindex, dat, par, i, arg);
+		for (c = 0, reached = 0; c < nCand; ++ c) {
+			j = candidate(nbindex, c);
+			k = position[j];
+			if ((k < 0) || (k >= resume) || (state->nEpsNeigh[k] < par->minPts))
+				continue;
+			if ((dist = calc_dist(dat, j, i, arg)) <= par->eps) {
+				dist = max_float(state->coreDist[k], dist);
+				if (dist < opticsdat->pt[i].reachDist)
+					opticsdat->pt[i].reachDist = dist;
+				reached = 1;
+			}
+		}
+
+		/* reached points are seeds of the global ordering */
+		if (reached && (seeds->heap != 0) && (i != *next))
+			seedlist_update(seeds, i, opticsdat->pt[i].reachDist);
+	}
+
+	/* restore the kept steps */
+	for (k = 0; k < resume; ++ k) {
+		i = state->index[k];
+		ordered_data[k] = &(opticsdat->pt[i]);
+		opticsdat->pt[i].processed = 1;
+		opticsdat->pt[i].index = i;
+		opticsdat->pt[i].order = k;
+		opticsdat->pt[i].coreDist = state->coreDist[k];
+		opticsdat->pt[i].reachDist = state->reachDist[k];
+		opticsdat->pt[i].nEpsNeigh = state->nEpsNeigh[k];
+		neighbour_remove(nbindex, i);
+	}
+
+	if (! silent)
+		fprintf(stderr, "%d new and %d removed points: resuming ordering at position %d of %d\n",
+			nNew, nRemoved, resume, state->nOrdered);
+
+	free(position);
+
+	return resume;
+}
+
+/*____________________________________________________________________________*/
+/** free state memory */
+void state_free(State *state)
+{
+	free(state->index);
+	free(state->coreDist);
+	free(state->reachDist);
+	free(state->nEpsNeigh);
+}
@@ -0,0 +1,37 @@
+/*==============================================================================
+state.h : ordering state for incremental updates
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef STATE_H
+#define STATE_H
+
+#include "neighbour.h"
+#include "optics.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* ordering state of a previous run */
+typedef struct {
+	int nPt; /* number of data points */
+	float eps; /* neighbourhood radius */
+	int minPts; /* minimum number of objects in neighbourhood */
+	int order; /* ordering, see arg.h */
+	int nOrdered; /* number of ordered points */
+	int *index; /* point index at each position of the ordering */
+	float *coreDist; /* core distance at each position */
+	float *reachDist; /* reachability distance at each position */
+	int *nEpsNeigh; /* number of unprocessed epsilon neighbours at each position */
+} State;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void state_write(char *fileName, Pt **ordered_data, int nOrdered, int nPt, Par *par, Arg *arg);
+void state_read(char *fileName, State *state, Dat *dat, Par *par, Arg *arg);
+int state_removed(char *fileName, char *removed, int nPt);
+int state_resume(State *state, Dat *dat, Par *par, OpticsDat *opticsdat, Pt **ordered_data, char *removed, NbIndex *nbindex, SeedList *seeds, Arg *arg, int *next);
+void state_free(State *state);
+
+#endif
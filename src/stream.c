@@ -0,0 +1,188 @@
+/*==============================================================================
+stream.c : sliding window over a stream of input points
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* Points enter the window one at a time and the oldest point expires
+	when the window is full. For finite epsilon the epsilon neighbourhood
+	of every window point is maintained: an entering point is compared
+	with each point in the window once, an expiring point is the first
+	entry of the lists of its neighbours. Lists are in stream order, which
+	is the index order of the window, so that they serve as cached
+	neighbourhoods (INDEX_CACHE) for the ordering of the window.
+	Memory is bounded by the window size. */
+
+#include "stream.h"
+
+/* Streaming reads xyz coordinates. */
+#ifdef DATAXYZ
+
+/*____________________________________________________________________________*/
+/** append neighbour s at distance 'dist' to the list of stored point p */
+__inline__ static void append_neighbour(Stream *stream, int p, int s, float dist)
+{
+	stream->list[p][stream->nList[p]].index = s;
+	stream->list[p][stream->nList[p] ++].dist = dist;
+	/* allocate more space to neighbour array if needed */
+	if (stream->nList[p] == stream->allocated[p]) {
+		stream->allocated[p] += 64;
+		stream->list[p] = safe_realloc(stream->list[p], stream->allocated[p] * sizeof(Epsn));
+	}
+}
+
+/*____________________________________________________________________________*/
+/** set up an empty window of 'size' points; 'cached' selects
+	maintained epsilon neighbourhoods */
+void stream_init(Stream *stream, int size, int cached)
+{
+	int p;
+
+	stream->size = size;
+	stream->nPt = 0;
+	stream->first = 0;
+	alloc_xyz(&(stream->ring), size);
+	stream->ring.nData = size;
+	stream->nEval = 0;
+
+	stream->cached = cached;
+	stream->list = 0;
+	stream->nList = 0;
+	stream->allocated = 0;
+	if (! stream->cached)
+		return;
+
+	stream->list = safe_malloc(size * sizeof(Epsn *));
+	stream->nList = safe_malloc(size * sizeof(int));
+	stream->allocated = safe_malloc(size * sizeof(int));
+	for (p = 0; p < size; ++ p) {
+		stream->allocated[p] = 64;
+		stream->list[p] = safe_malloc(stream->allocated[p] * sizeof(Epsn));
+		stream->nList[p] = 0;
+	}
+}
+
+/*____________________________________________________________________________*/
+/** remove the oldest point from the window */
+static void expire(Stream *stream)
+{
+	int c, q;
+	int o = stream->first % stream->size;
+
+	/* the oldest point is the first neighbour of its neighbours */
+	for (c = 0; stream->cached && (c < stream->nList[o]); ++ c) {
+		q = stream->list[o][c].index % stream->size;
+		assert(stream->list[q][0].index == stream->first);
+		-- stream->nList[q];
+		memmove(&(stream->list[q][0]), &(stream->list[q][1]), stream->nList[q] * sizeof(Epsn));
+	}
+	if (stream->cached)
+		stream->nList[o] = 0;
+
+	++ stream->first;
+	-- stream->nPt;
+}
+
+/*____________________________________________________________________________*/
+/** read the next point of the stream into the window;
+	returns 0 at the end of the stream, otherwise 1 */
+int stream_read(Stream *stream, FILE *inFile, Par *par, Arg *arg)
+{
+	int s, p, q, n;
+	float dist;
+	Vec point;
+
+	if ((n = fscanf(inFile, "%f%f%f", &(point.x), &(point.y), &(point.z))) != 3) {
+		if (n != EOF) {
+			fprintf(stderr, "input data format has to be: [float] [float] [float]\n");
+			fprintf(stderr, "format error after point %d\n", stream->first + stream->nPt);
+			exit(1);
+		}
+		return 0;
+	}
+
+	if (stream->nPt == stream->size)
+		expire(stream);
+
+	/* new point at the end of the window */
+	p = (stream->first + stream->nPt) % stream->size;
+	stream->ring.x[p] = point.x;
+	stream->ring.y[p] = point.y;
+	stream->ring.z[p] = point.z;
+
+	/* distances to the window points, in stream order;
+		the older point is the first argument, as in neighbour_cache() */
+	for (s = stream->first; stream->cached && (s < stream->first + stream->nPt); ++ s) {
+		q = s % stream->size;
+		dist = calc_dist(&(stream->ring), q, p, arg);
+		++ stream->nEval;
+		if (dist <= par->eps) {
+			append_neighbour(stream, p, s, dist);
+			append_neighbour(stream, q, stream->first + stream->nPt, dist);
+		}
+	}
+
+	++ stream->nPt;
+
+	return 1;
+}
+
+/*____________________________________________________________________________*/
+/** copy the window points into 'dat' (oldest point first) and, if
+	neighbourhoods are maintained, their neighbour lists into 'nbcache';
+	returns 1 if 'nbcache' is set, otherwise 0 */
+int stream_window(Stream *stream, Dat *dat, NbIndex *nbcache)
+{
+	int i, c, p;
+
+	dat->nData = stream->nPt;
+	alloc_xyz(dat, stream->nPt);
+	for (i = 0; i < stream->nPt; ++ i) {
+		p = (stream->first + i) % stream->size;
+		dat->x[i] = stream->ring.x[p];
+		dat->y[i] = stream->ring.y[p];
+		dat->z[i] = stream->ring.z[p];
+	}
+
+	if (! stream->cached)
+		return 0;
+
+	/* cached neighbourhoods with window indices */
+	nbcache->type = INDEX_CACHE;
+	nbcache->nPt = stream->nPt;
+	nbcache->allocated = 64;
+	nbcache->cand = safe_malloc(nbcache->allocated * sizeof(int));
+	nbcache->nEval = 0;
+	nbcache->nEvalBrute = 0;
+	nbcache->nRemoved = 0;
+	nbcache->slice = 0;
+	nbcache->list = safe_malloc(stream->nPt * sizeof(Epsn *));
+	nbcache->nList = safe_malloc(stream->nPt * sizeof(int));
+	for (i = 0; i < stream->nPt; ++ i) {
+		p = (stream->first + i) % stream->size;
+		nbcache->nList[i] = stream->nList[p];
+		nbcache->list[i] = safe_malloc((stream->nList[p] + 1) * sizeof(Epsn));
+		for (c = 0; c < stream->nList[p]; ++ c) {
+			nbcache->list[i][c].index = stream->list[p][c].index - stream->first;
+			nbcache->list[i][c].dist = stream->list[p][c].dist;
+		}
+	}
+
+	return 1;
+}
+
+/*____________________________________________________________________________*/
+/** free window memory */
+void stream_free(Stream *stream)
+{
+	int p;
+
+	for (p = 0; stream->cached && (p < stream->size); ++ p)
+		free(stream->list[p]);
+	free(stream->list);
+	free(stream->nList);
+	free(stream->allocated);
+	free_xyz(&(stream->ring));
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*==============================================================================
+stream.h : sliding window over a stream of input points
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "neighbour.h"
+#include "optics.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* sliding window: the last 'size' points of the stream */
+typedef struct {
+	int size; /* window size */
+	int nPt; /* number of points in the window */
+	int first; /* stream index of the oldest point in the window */
+	Dat ring; /* window points; point s is stored at s % size */
+	int cached; /* flag for maintained epsilon neighbourhoods */
+	Epsn **list; /* epsilon neighbours (stream index) of each stored point */
+	int *nList; /* number of epsilon neighbours of each stored point */
+	int *allocated; /* allocated size of each neighbour list */
+	long long nEval; /* number of distance evaluations */
+} Stream;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void stream_init(Stream *stream, int size, int cached);
+int stream_read(Stream *stream, FILE *inFile, Par *par, Arg *arg);
+int stream_window(Stream *stream, Dat *dat, NbIndex *nbcache);
+void stream_free(Stream *stream);
+
+#endif
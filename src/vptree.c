@@ -0,0 +1,229 @@
+/*==============================================================================
+vptree.c : vantage-point tree for range queries in metric spaces
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#include "vptree.h"
+
+/* maximal number of points in a leaf node */
+#define LEAFSIZE 8
+/* Pruning relies on the triangle inequality of calc_dist(). Float rounding
+	can violate it by a few units in the last place, relative to the
+	distances involved; pruning bounds are widened by TOL accordingly. */
+#define TOL 1.0e-4
+
+/*____________________________________________________________________________*/
+/** swap two permutation entries together with their distances */
+__inline__ static void swap_entry(VpTree *tree, int a, int b)
+{
+	int tmp = tree->perm[a];
+	float tmpDist = tree->vpDist[a];
+
+	tree->perm[a] = tree->perm[b];
+	tree->perm[b] = tmp;
+	tree->vpDist[a] = tree->vpDist[b];
+	tree->vpDist[b] = tmpDist;
+}
+
+/*____________________________________________________________________________*/
+/** partial sort of entries [start,end) such that entry 'mid' holds
+	the median distance to the vantage point (quickselect) */
+static void select_median(VpTree *tree, int start, int end, int mid)
+{
+	int l, r, i, j;
+	float pivot;
+
+	/* Hoare partition keeps runs of equal distances balanced */
+	l = start;
+	r = end - 1;
+	while (r > l) {
+		pivot = tree->vpDist[l + (r - l) / 2];
+		i = l;
+		j = r;
+		while (i <= j) {
+			while (tree->vpDist[i] < pivot)
+				++ i;
+			while (tree->vpDist[j] > pivot)
+				-- j;
+			if (i <= j) {
+				swap_entry(tree, i, j);
+				++ i;
+				-- j;
+			}
+		}
+
+		if (mid <= j)
+			r = j;
+		else if (mid >= i)
+			l = i;
+		else
+			return;
+	}
+}
+
+/*____________________________________________________________________________*/
+/** recursively build node over entries [start,end) and return its index */
+static int build_node(VpTree *tree, Dat *dat, Arg *arg, int start, int end, int parent)
+{
+	int n, p, k, mid;
+
+	/* allocate more nodes if needed */
+	if (tree->nNode == tree->allocated) {
+		tree->allocated += 64;
+		tree->node = safe_realloc(tree->node, tree->allocated * sizeof(VpNode));
+	}
+
+	n = tree->nNode ++;
+	tree->node[n].vp = -1;
+	tree->node[n].mu = 0.;
+	tree->node[n].inside = -1;
+	tree->node[n].outside = -1;
+	tree->node[n].start = start;
+	tree->node[n].end = end;
+	tree->node[n].parent = parent;
+	tree->node[n].nActive = end - start;
+
+	/* leaf node: entries keep the distance to the parent vantage point */
+	if ((end - start) <= LEAFSIZE) {
+		for (p = start; p < end; ++ p)
+			tree->node_of[tree->perm[p]] = n;
+		return n;
+	}
+
+	/* the first entry is the vantage point of this node */
+	tree->node[n].vp = tree->perm[start];
+	tree->node_of[tree->perm[start]] = n;
+	for (p = start + 1; p < end; ++ p)
+		tree->vpDist[p] = calc_dist(dat, tree->perm[p], tree->node[n].vp, arg);
+
+	/* split remaining entries at the median distance; entries equal to mu
+		may fall on either side, which keeps the tree balanced for ties */
+	mid = start + 1 + (end - start - 1) / 2;
+	select_median(tree, start + 1, end, mid);
+	tree->node[n].mu = tree->vpDist[mid];
+
+	/* the node array may be reallocated by the recursion: assign via index */
+	k = build_node(tree, dat, arg, start + 1, mid + 1, n);
+	tree->node[n].inside = k;
+	k = build_node(tree, dat, arg, mid + 1, end, n);
+	tree->node[n].outside = k;
+
+	return n;
+}
+
+/*____________________________________________________________________________*/
+/** build tree over all data points; the tree is defined by calc_dist() only */
+void vptree_build(VpTree *tree, Dat *dat, Arg *arg)
+{
+	int i;
+
+	tree->nPt = dat->nData;
+	tree->perm = safe_malloc(tree->nPt * sizeof(int));
+	tree->vpDist = safe_malloc(tree->nPt * sizeof(float));
+	tree->node_of = safe_malloc(tree->nPt * sizeof(int));
+	tree->removed = safe_malloc(tree->nPt * sizeof(char));
+	tree->allocated = 64;
+	tree->node = safe_malloc(tree->allocated * sizeof(VpNode));
+	tree->nNode = 0;
+	tree->nEval = 0;
+
+	for (i = 0; i < tree->nPt; ++ i) {
+		tree->perm[i] = i;
+		tree->vpDist[i] = 0.;
+		tree->removed[i] = 0;
+	}
+
+	build_node(tree, dat, arg, 0, tree->nPt, -1);
+}
+
+/*____________________________________________________________________________*/
+/** append candidate */
+__inline__ static void add_cand(int j, int **cand, int *allocated, int *nCand)
+{
+	(*cand)[(*nCand) ++] = j;
+	/* allocate more space to candidate array if needed */
+	if (*nCand == *allocated) {
+		*allocated += 64;
+		*cand = safe_realloc(*cand, *allocated * sizeof(int));
+	}
+}
+
+/*____________________________________________________________________________*/
+/** recursive range search; 'dParent' is the distance of the query
+	to the vantage point of the parent node */
+static void range_node(VpTree *tree, Dat *dat, Arg *arg, int n, int i, float radius, float dParent, int **cand, int *allocated, int *nCand)
+{
+	int p, j;
+	float d, tol;
+	VpNode *node = &(tree->node[n]);
+
+	if (node->nActive == 0)
+		return;
+
+	/* leaf: prune entries by their distance to the parent vantage point */
+	if (node->vp < 0) {
+		for (p = node->start; p < node->end; ++ p) {
+			j = tree->perm[p];
+			if (tree->removed[j])
+				continue;
+			if ((dParent >= 0.) &&
+				(fabs(dParent - tree->vpDist[p]) > radius + TOL * (dParent + tree->vpDist[p] + radius)))
+				continue;
+			add_cand(j, cand, allocated, nCand);
+		}
+		return;
+	}
+
+	d = calc_dist(dat, i, node->vp, arg);
+	++ tree->nEval;
+	tol = TOL * (d + node->mu + radius);
+
+	if ((! tree->removed[node->vp]) && (d <= radius + tol))
+		add_cand(node->vp, cand, allocated, nCand);
+
+	/* triangle inequality: inside points have d(vp,j) <= mu,
+		outside points have d(vp,j) >= mu */
+	if (d - radius <= node->mu + tol)
+		range_node(tree, dat, arg, node->inside, i, radius, d, cand, allocated, nCand);
+	if (d + radius >= node->mu - tol)
+		range_node(tree, dat, arg, node->outside, i, radius, d, cand, allocated, nCand);
+}
+
+/*____________________________________________________________________________*/
+/** collect candidates within distance 'radius' of point i in 'cand';
+	the candidate order is tree order; returns the number of candidates */
+int vptree_range(VpTree *tree, Dat *dat, int i, float radius, Arg *arg, int **cand, int *allocated)
+{
+	int nCand = 0;
+
+	range_node(tree, dat, arg, 0, i, radius, -1., cand, allocated, &nCand);
+
+	return nCand;
+}
+
+/*____________________________________________________________________________*/
+/** remove point i from all subsequent range searches */
+void vptree_remove(VpTree *tree, int i)
+{
+	int n;
+
+	if (tree->removed[i])
+		return;
+	tree->removed[i] = 1;
+
+	for (n = tree->node_of[i]; n >= 0; n = tree->node[n].parent)
+		-- tree->node[n].nActive;
+}
+
+/*____________________________________________________________________________*/
+/** free tree memory */
+void vptree_free(VpTree *tree)
+{
+	free(tree->perm);
+	free(tree->vpDist);
+	free(tree->node_of);
+	free(tree->removed);
+	free(tree->node);
+}
+
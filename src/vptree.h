@@ -0,0 +1,49 @@
+/*==============================================================================
+vptree.h : vantage-point tree for range queries in metric spaces
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef VPTREE_H
+#define VPTREE_H
+
+#include <math.h>
+
+#include "optics.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* tree node */
+typedef struct {
+	int vp; /* vantage point, -1 for leaf */
+	float mu; /* median distance to vantage point */
+	int inside; /* child node with d(vp,j) <= mu */
+	int outside; /* child node with d(vp,j) >= mu */
+	int start; /* first leaf entry in the permutation array */
+	int end; /* one past the last leaf entry in the permutation array */
+	int parent; /* parent node, -1 for root */
+	int nActive; /* number of points not yet removed from subtree */
+} VpNode;
+
+/* vantage-point tree */
+typedef struct {
+	int nPt; /* number of points */
+	int *perm; /* point indices in tree order */
+	float *vpDist; /* distance of each point to the vantage point of its parent */
+	int *node_of; /* node holding each point (as vantage point or leaf entry) */
+	char *removed; /* flag for points removed from the tree */
+	VpNode *node; /* tree nodes */
+	int nNode; /* number of nodes */
+	int allocated; /* allocated nodes */
+	long long nEval; /* number of distance evaluations in queries */
+} VpTree;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void vptree_build(VpTree *tree, Dat *dat, Arg *arg);
+int vptree_range(VpTree *tree, Dat *dat, int i, float radius, Arg *arg, int **cand, int *allocated);
+void vptree_remove(VpTree *tree, int i);
+void vptree_free(VpTree *tree);
+
+#endif
@@ -0,0 +1,250 @@
+/*==============================================================================
+xi.c : cluster extraction by steep areas of the reachability plot (Xi)
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Reference :
+	- Ankerst et al., Proc.ACM SIGMOD'99 Int. Conf. on Management
+		of Data, Philadelphia PA, 1999 (section 4.3).
+Read the COPYING file for license information.
+==============================================================================*/
+
+/* A point p is steep down if RD(p) * (1 - xi) >= RD(p + 1) and steep up
+	if RD(p) <= RD(p + 1) * (1 - xi). Steep areas are maximal runs of steep
+	points with at most minPts non-steep points in the same direction in
+	between. The reachability plot is walked once: steep down areas are
+	kept in a list while the RD between them and the current point (mib)
+	stays below their start; each steep up area closes a cluster with every
+	listed steep down area that matches it (Definition 11). The filter
+	and both corrections of the cluster ends follow the implementation
+	in scikit-learn, without the predecessor correction. Points that are
+	not reached within epsilon (RD = eps) have undefined (infinite) RD. */
+
+#include "xi.h"
+
+extern int silent;
+
+/*____________________________________________________________________________*/
+/** max floats */
+__inline__ static float max_float(float a, float b)
+{
+	return ((a > b ) ? a : b);
+}
+
+/*____________________________________________________________________________*/
+/** end of the steep area starting at 'start'; the area ends at a point
+	in the 'opposite' direction or after more than minPts non-steep points */
+static int extend_area(char *steep, char *opposite, int start, int npoints, int minPts)
+{
+	int i;
+	int end = start;
+	int nNonSteep = 0; /* consecutive non-steep points */
+
+	for (i = start; i < npoints; ++ i) {
+		if (steep[i]) {
+			nNonSteep = 0;
+			end = i;
+		} else if (opposite[i]) {
+			break;
+		} else if (++ nNonSteep > minPts) {
+			break;
+		}
+	}
+
+	return end;
+}
+
+/*____________________________________________________________________________*/
+/** keep the steep down areas whose start is steep with respect to 'mib'
+	and update their mib; returns the number of kept areas */
+static int filter_areas(SteepArea *sda, int nSda, float mib, float *rd, float xiComp)
+{
+	int a, nKept = 0;
+
+	if (isinf(mib))
+		return 0;
+
+	for (a = 0; a < nSda; ++ a) {
+		if (mib <= rd[sda[a].start] * xiComp) {
+			sda[nKept] = sda[a];
+			sda[nKept].mib = max_float(sda[nKept].mib, mib);
+			++ nKept;
+		}
+	}
+
+	return nKept;
+}
+
+/*____________________________________________________________________________*/
+/** order clusters by start, then by decreasing end (parents first) */
+static int compare_cluster(const void *a, const void *b)
+{
+	const Cluster *ca = a;
+	const Cluster *cb = b;
+
+	if (ca->start != cb->start)
+		return ((ca->start < cb->start) ? -1 : 1);
+	if (ca->end != cb->end)
+		return ((ca->end > cb->end) ? -1 : 1);
+	return 0;
+}
+
+/*____________________________________________________________________________*/
+/** extract clusters with steepness 'xi' from the ordering; clusters are
+	numbered in order of their start, enclosing clusters first, and the
+	parent of a cluster is the smallest cluster enclosing it */
+void extract_clusters_xi(ClusterList *cluster_list, Pt **ordered_data, int npoints, Par *par, float xi, int *ptr_mem_allocated, int *ptr_pseudoClusterFlag)
+{
+	int i, k, a, n; /* indices */
+	int index = 0; /* first point not yet in a steep area */
+	int start, end, upStart, upEnd; /* cluster and steep up area */
+	float mib = 0.; /* maximal RD since the last steep area */
+	float dMax; /* RD at the start of a steep down area */
+	float xiComp = 1. - xi;
+	float ratio;
+	float *rd = safe_malloc((npoints + 1) * sizeof(float)); /* RDs in order */
+	float *cd = safe_malloc(npoints * sizeof(float)); /* CDs in order */
+	char *steepUp = safe_malloc(npoints * sizeof(char));
+	char *steepDown = safe_malloc(npoints * sizeof(char));
+	char *up = safe_malloc(npoints * sizeof(char));
+	char *down = safe_malloc(npoints * sizeof(char));
+	SteepArea *sda = safe_malloc(npoints * sizeof(SteepArea)); /* steep down areas */
+	int nSda = 0; /* number of steep down areas */
+	int *stack = 0; /* enclosing clusters */
+	int nStack = 0;
+	float minCD0 = par->eps + 1; /* CD of noise points */
+	Rmq cdMin; /* range minimum of CD */
+
+	/* RD plot ending with an undefined RD */
+	for (i = 0; i < npoints; ++ i) {
+		rd[i] = ((*ordered_data[i]).reachDist >= par->eps) ? INFINITY : (*ordered_data[i]).reachDist;
+		cd[i] = (*ordered_data[i]).coreDist;
+	}
+	rd[npoints] = INFINITY;
+
+	/* steepness of each point with respect to its successor */
+	for (i = 0; i < npoints; ++ i) {
+		ratio = rd[i] / rd[i + 1];
+		steepUp[i] = (ratio <= xiComp);
+		steepDown[i] = (ratio >= 1. / xiComp);
+		down[i] = (ratio > 1.);
+		up[i] = (ratio < 1.);
+	}
+
+	*ptr_mem_allocated = 10; /* allocation counter */
+	cluster_list->cluster = safe_malloc((*ptr_mem_allocated) * sizeof(Cluster));
+	cluster_list->nCluster = 0;
+
+	for (i = 0; i < npoints; ++ i) {
+		if ((i < index) || ! (steepUp[i] || steepDown[i]))
+			continue;
+
+		for (k = index; k <= i; ++ k)
+			mib = max_float(mib, rd[k]);
+		nSda = filter_areas(sda, nSda, mib, rd, xiComp);
+
+		/* steep down area */
+		if (steepDown[i]) {
+			sda[nSda].start = i;
+			sda[nSda].end = extend_area(steepDown, up, i, npoints, par->minPts);
+			sda[nSda].mib = 0.;
+			index = sda[nSda].end + 1;
+			++ nSda;
+			mib = rd[index];
+			continue;
+		}
+
+		/* steep up area */
+		upStart = i;
+		upEnd = extend_area(steepUp, down, i, npoints, par->minPts);
+		index = upEnd + 1;
+		mib = rd[index];
+
+		/* clusters between each steep down area and this steep up area */
+		for (a = 0; a < nSda; ++ a) {
+			start = sda[a].start;
+			end = upEnd;
+
+			/* the end must be at least as high as the RD in between */
+			if (rd[end + 1] * xiComp < sda[a].mib)
+				continue;
+
+			/* move the higher end to the level of the lower one */
+			dMax = rd[sda[a].start];
+			if (dMax * xiComp >= rd[end + 1]) {
+				while ((rd[start + 1] > rd[end + 1]) && (start < sda[a].end))
+					++ start;
+			} else if (rd[end + 1] * xiComp >= dMax) {
+				while ((rd[end - 1] > dMax) && (end > upStart))
+					-- end;
+			}
+
+			/* at least minPts points, ends within the steep areas */
+			if ((end - start + 1 < par->minPts) || (start > sda[a].end) || (end < upStart))
+				continue;
+
+			cluster_list->cluster[cluster_list->nCluster].start = start;
+			cluster_list->cluster[cluster_list->nCluster].end = end;
+			cluster_list->nCluster ++;
+
+			/* allocate more memory if needed */
+			if (cluster_list->nCluster == (*ptr_mem_allocated)) {
+				(*ptr_mem_allocated) += 10;
+				cluster_list->cluster = safe_realloc(cluster_list->cluster, (*ptr_mem_allocated) * sizeof(Cluster));
+			}
+		}
+	}
+
+	/* hierarchy: enclosing clusters first, duplicates removed */
+	qsort(cluster_list->cluster, cluster_list->nCluster, sizeof(Cluster), compare_cluster);
+	for (i = 0, n = 0; i < cluster_list->nCluster; ++ i)
+		if ((n == 0) || (compare_cluster(&(cluster_list->cluster[n - 1]), &(cluster_list->cluster[i])) != 0))
+			cluster_list->cluster[n ++] = cluster_list->cluster[i];
+	cluster_list->nCluster = n;
+
+	if (n > 0) {
+		rmq_init(&cdMin, cd, npoints, 0);
+		stack = safe_malloc(n * sizeof(int));
+	}
+
+	for (i = 0; i < n; ++ i) {
+		start = cluster_list->cluster[i].start;
+		end = cluster_list->cluster[i].end;
+
+		/* smallest enclosing cluster */
+		while ((nStack > 0) && (cluster_list->cluster[stack[nStack - 1]].end < end))
+			-- nStack;
+		cluster_list->cluster[i].parent = (nStack > 0) ? stack[nStack - 1] : -1;
+		stack[nStack ++] = i;
+
+		cluster_list->cluster[i].size = end - start + 1;
+		k = rmq_query(&cdMin, start, end);
+		if (cd[k] < minCD0) {
+			cluster_list->cluster[i].minCD = cd[k];
+			cluster_list->cluster[i].minCDid = (*ordered_data[k]).order;
+		} else {
+			cluster_list->cluster[i].minCD = minCD0;
+			cluster_list->cluster[i].minCDid = -1;
+			/* cluster has no valid representative */
+			(*ptr_pseudoClusterFlag) = 1;
+		}
+	}
+
+	if (! silent)
+		fprintf(stderr, "\n%d clusters in %d points extracted with xi %5.3f\n", n, npoints, xi);
+
+	/* safe free if no cluster has been identified */
+	if (n == 0) {
+		free(cluster_list->cluster);
+	} else {
+		rmq_free(&cdMin);
+		free(stack);
+	}
+
+	free(rd);
+	free(cd);
+	free(steepUp);
+	free(steepDown);
+	free(up);
+	free(down);
+	free(sda);
+}
+
@@ -0,0 +1,30 @@
+/*==============================================================================
+xi.h : cluster extraction by steep areas of the reachability plot (Xi)
+Copyright (C) 2008-2016 Jens Kleinjung and Alessandro Pandini
+Read the COPYING file for license information.
+==============================================================================*/
+
+#ifndef XI_H
+#define XI_H
+
+#include <math.h>
+
+#include "optics.h"
+#include "rmq.h"
+
+/*____________________________________________________________________________*/
+/* structures */
+
+/* steep down area */
+typedef struct {
+	int start; /* first point */
+	int end; /* last point */
+	float mib; /* maximal RD between the area and the current point */
+} SteepArea;
+
+/*____________________________________________________________________________*/
+/* prototypes */
+void extract_clusters_xi(ClusterList *cluster_list, Pt **ordered_data, int npoints, Par *par, float xi, int *ptr_mem_allocated, int *ptr_pseudoClusterFlag);
+
+#endif
+
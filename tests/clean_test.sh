@@ -3,3 +3,4 @@
 #  clean dir
 
 rm -f output.dat cluster.dat center.dat unique.dat
+rm -rf brute kdtree grid vptree mih pivot incremental minpts stream extract xi threads prefetch coredist mpi vector
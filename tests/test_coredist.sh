@@ -0,0 +1,10 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test core distances over all points on xyz coordinate file:
+# they are those of the spanning tree ordering
+
+mkdir -p coredist/mst coredist/all
+../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order mst --cdfile cd.dat --outpath coredist/mst --silent || exit 1
+../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order global --coredist all --cdfile cd.dat --outpath coredist/all --silent || exit 1
+../src/optics_xyz --datafile 100.dat --minpts 5 --order local --coredist all --outpath coredist/all --silent || exit 1
+cmp coredist/mst/cd.dat coredist/all/cd.dat || exit 1
@@ -0,0 +1,15 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test cluster extraction by range queries against sorting on xyz coordinate file
+# (and sorting on several threads against one thread)
+
+for minpts in 2 5; do
+	mkdir -p extract/sort$minpts extract/threads$minpts extract/rmq$minpts
+	../src/optics_xyz --datafile 100.dat --minpts $minpts --eps 1.5 --threads 1 --outpath extract/sort$minpts --silent || exit 1
+	../src/optics_xyz --datafile 100.dat --minpts $minpts --eps 1.5 --threads 4 --outpath extract/threads$minpts --silent || exit 1
+	cmp extract/sort$minpts/cluster.dat extract/threads$minpts/cluster.dat || exit 1
+	../src/optics_xyz --datafile 100.dat --minpts $minpts --eps 1.5 --extract rmq --outpath extract/rmq$minpts --silent || exit 1
+	cmp extract/sort$minpts/cluster.dat extract/rmq$minpts/cluster.dat || exit 1
+	cmp extract/sort$minpts/center.dat extract/rmq$minpts/center.dat || exit 1
+	cmp extract/sort$minpts/unique.dat extract/rmq$minpts/unique.dat || exit 1
+done
@@ -0,0 +1,17 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test incremental updates against orderings from scratch on xyz coordinate file
+
+mkdir -p incremental/old incremental/new incremental/scratch
+head -90 100.dat > incremental/old.dat
+echo "3 17 42 95" > incremental/removed.dat
+
+for order in local global; do
+	# previous run on the first 90 points
+	../src/optics_xyz --datafile incremental/old.dat --minpts 5 --eps 1.5 --order $order --outpath incremental/old --statefile state.dat --silent || exit 1
+	# 10 points added, 4 points removed
+	../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order $order --outpath incremental/new --resume incremental/old/state.dat --removed incremental/removed.dat --silent || exit 1
+	../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order $order --outpath incremental/scratch --removed incremental/removed.dat --silent || exit 1
+	cmp incremental/new/output.dat incremental/scratch/output.dat || exit 1
+	cmp incremental/new/cluster.dat incremental/scratch/cluster.dat || exit 1
+done
@@ -0,0 +1,13 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test neighbour search indices against brute force on xyz coordinate file
+
+for index in brute kdtree grid vptree; do
+	mkdir -p $index
+	../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --index $index --outpath $index --silent || exit 1
+done
+
+for index in kdtree grid vptree; do
+	cmp brute/output.dat $index/output.dat || exit 1
+	cmp brute/cluster.dat $index/cluster.dat || exit 1
+done
@@ -0,0 +1,13 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test periodic neighbour search indices against brute force on angle file
+
+for index in brute kdtree grid; do
+	mkdir -p $index
+	../src/optics_ang --datafile ang.dat --minpts 10 --eps 40 --index $index --outpath $index --silent || exit 1
+done
+
+for index in kdtree grid; do
+	cmp brute/output.dat $index/output.dat || exit 1
+	cmp brute/cluster.dat $index/cluster.dat || exit 1
+done
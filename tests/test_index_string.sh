@@ -0,0 +1,13 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test metric search engines against brute force on string file
+
+for index in brute vptree mih pivot; do
+	mkdir -p $index
+	../src/optics_str --datafile string.dat --minpts 50 --eps 50 --index $index --outpath $index --silent || exit 1
+done
+
+for index in vptree mih pivot; do
+	cmp brute/output.dat $index/output.dat || exit 1
+	cmp brute/cluster.dat $index/cluster.dat || exit 1
+done
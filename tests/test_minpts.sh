@@ -0,0 +1,13 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test several minpts values in one run against single runs on xyz coordinate file
+
+mkdir -p minpts/sweep
+../src/optics_xyz --datafile 100.dat --minpts 3,5,8 --eps 1.5 --index kdtree --outpath minpts/sweep --silent || exit 1
+
+for minpts in 3 5 8; do
+	mkdir -p minpts/$minpts
+	../src/optics_xyz --datafile 100.dat --minpts $minpts --eps 1.5 --outpath minpts/$minpts --silent || exit 1
+	cmp minpts/$minpts/output.dat minpts/sweep/minpts$minpts.output.dat || exit 1
+	cmp minpts/$minpts/cluster.dat minpts/sweep/minpts$minpts.cluster.dat || exit 1
+done
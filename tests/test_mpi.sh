@@ -1,5 +1,17 @@
-#! /bin/csh
+#! /bin/sh
 #_______________________________________________________________________________
-# test OPTICS MPI on xyz coordinate file
+# test OPTICS MPI on xyz coordinate file: several ranks against 1 rank
+# (skipped unless built with 'configure --enable-data-xyz --enable-mpi';
+#	number of ranks MPI_NP, default 2)
+
+[ -x ../src/optics_xyz_mpi ] || exit 77
+np=${MPI_NP:-2}
 
 mpirun -np 1 ../src/optics_xyz_mpi --datafile point.dat || exit 1
+
+mkdir -p mpi/1 mpi/$np
+for n in 1 $np; do
+	mpirun -np $n --oversubscribe ../src/optics_xyz_mpi --datafile 100.dat --minpts 5 --eps 1.5 --index kdtree --outpath mpi/$n --silent || exit 1
+done
+cmp mpi/1/output.dat mpi/$np/output.dat || exit 1
+cmp mpi/1/cluster.dat mpi/$np/cluster.dat || exit 1
@@ -0,0 +1,8 @@
+#! /bin/sh
+#_______________________________________________________________________________
+#  test global and spanning tree orderings on xyz coordinate file
+
+../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order global || exit 1
+../src/optics_xyz --datafile 100.dat --minpts 5 --order global || exit 1
+../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order mst || exit 1
+../src/optics_xyz --datafile 100.dat --minpts 5 --order mst || exit 1
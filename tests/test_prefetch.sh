@@ -0,0 +1,12 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test prefetched neighbourhoods against the plain search on xyz coordinate file
+
+for order in local global; do
+	for prefetch in 0 4; do
+		mkdir -p prefetch/$order.$prefetch
+		../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --order $order --prefetch $prefetch --threads 4 --outpath prefetch/$order.$prefetch --silent || exit 1
+	done
+	cmp prefetch/$order.0/output.dat prefetch/$order.4/output.dat || exit 1
+	cmp prefetch/$order.0/cluster.dat prefetch/$order.4/cluster.dat || exit 1
+done
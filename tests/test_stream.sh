@@ -0,0 +1,14 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test sliding windows over a stream against single runs on the window points
+
+mkdir -p stream/window
+../src/optics_xyz --datafile 100.dat --window 40 --stride 30 --minpts 5 --eps 1.5 --outpath stream/window --silent || exit 1
+
+for first in 0 30 60; do
+	mkdir -p stream/$first
+	sed -n "$((first + 1)),$((first + 40))p" 100.dat > stream/$first/window.dat
+	../src/optics_xyz --datafile stream/$first/window.dat --minpts 5 --eps 1.5 --outpath stream/$first --silent || exit 1
+	cmp stream/$first/output.dat stream/window/window$first.output.dat || exit 1
+	cmp stream/$first/cluster.dat stream/window/window$first.cluster.dat || exit 1
+done
@@ -0,0 +1,21 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test neighbour search on several threads against one thread on xyz coordinate file
+# (50 copies of the 100 points: enough candidates per point for the parallel scan)
+
+mkdir -p threads/1 threads/4
+for copy in $(seq 50); do cat 100.dat; done > threads/5000.dat
+
+for threads in 1 4; do
+	../src/optics_xyz --datafile threads/5000.dat --minpts 5 --eps 1.5 --threads $threads --outpath threads/$threads --silent || exit 1
+done
+cmp threads/1/output.dat threads/4/output.dat || exit 1
+cmp threads/1/cluster.dat threads/4/cluster.dat || exit 1
+
+# default (infinite) epsilon: bounded search over all unprocessed points
+mkdir -p threads/knn1 threads/knn4
+for threads in 1 4; do
+	../src/optics_xyz --datafile threads/5000.dat --minpts 5 --threads $threads --outpath threads/knn$threads --silent || exit 1
+done
+cmp threads/knn1/output.dat threads/knn4/output.dat || exit 1
+cmp threads/knn1/cluster.dat threads/knn4/cluster.dat || exit 1
@@ -3,3 +3,12 @@
 # test OPTICS on vec data
 
 ../src/optics_vec --datafile vector.dat || exit 1
+
+# vectors longer than 512 elements: zeros appended to the vectors
+#	leave the (Manhattan) distances and therefore the ordering unchanged
+mkdir -p vector/7 vector/700
+awk '{ s = $0; for (k = NF; k < 700; ++ k) s = s " 0.0"; print s }' vector.dat > vector/700.dat
+../src/optics_vec --datafile vector.dat --eps 1 --minpts 2 --outpath vector/7 --silent || exit 1
+../src/optics_vec --datafile vector/700.dat --eps 1 --minpts 2 --outpath vector/700 --silent || exit 1
+cmp vector/7/output.dat vector/700/output.dat || exit 1
+cmp vector/7/cluster.dat vector/700/cluster.dat || exit 1
@@ -0,0 +1,25 @@
+#! /bin/sh
+#_______________________________________________________________________________
+# test Xi cluster extraction on xyz coordinate file:
+# every cluster lies within its parent, which is listed before it
+
+for xi in 0.05 0.2; do
+	mkdir -p xi/$xi
+done
+../src/optics_xyz --datafile 100.dat --minpts 5 --eps 1.5 --extract xi --xi 0.05 --outpath xi/0.05 --silent || exit 1
+../src/optics_xyz --datafile 100.dat --minpts 5 --extract xi --xi 0.2 --outpath xi/0.2 --silent || exit 1
+
+for xi in 0.05 0.2; do
+	awk 'NR > 1 {
+		if ($2 >= $1) exit 1;
+		if ($2 >= 0 && ($3 < start[$2] || $4 > end[$2])) exit 1;
+		start[$1] = $3; end[$1] = $4; n ++;
+	} END { if (n == 0) exit 1 }' xi/$xi/cluster.dat || exit 1
+done
+
+# known clusters: 10 points spaced 0.1 apart on a line, then 2 groups
+# of 5 such points 0.6 apart; Xi finds the whole set, both groups of 10
+# points and the 2 groups of 5 points (reference test_xi.out)
+mkdir -p xi/known
+../src/optics_xyz --datafile xi.dat --minpts 3 --eps 10 --extract xi --xi 0.1 --outpath xi/known --silent || exit 1
+cmp xi/known/cluster.dat test_xi.out || exit 1